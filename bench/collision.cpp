@@ -0,0 +1,223 @@
+// Collision benchmark on a dense PDC engagement (asteroids, a few ships,
+// torpedoes and clouds of PDC rounds round the ships).
+//
+// Broadphase: the old every-entity-against-every-other check against the
+// spatial hash. Prints the pairs each one tests and the time per tick, and
+// checks both find the same overlapping pairs.
+//
+// Detection: the grid's cells tested on a thread pool of 1 worker and of
+// one per core, like CollisionSystem does. Checks both find the same
+// contacts in the same order.
+//
+//   cmake -S . -B build -DCMAKE_BUILD_TYPE=Release -DROCI_BUILD_BENCHMARKS=ON
+//   cmake --build build --target bench_collision && ./build/bin/bench_collision
+#include "../include/collision.hpp"
+#include "../include/components.hpp"
+#include "../include/ecs.hpp"
+#include "../include/spatialhash.hpp"
+#include "../include/threadpool.hpp"
+#include <chrono>
+#include <cstdlib>
+#include <iomanip>
+#include <iostream>
+#include <memory>
+#include <thread>
+#include <utility>
+#include <vector>
+
+namespace {
+
+float rnd(float min, float max) { return min + static_cast<float>(std::rand()) / RAND_MAX * (max - min); }
+
+Entity collider(Coordinator &ecs, sf::Vector2f pos, CollisionType type, float halfWidth, float halfHeight) {
+  Entity e = ecs.createEntity();
+  ecs.addComponent(e, Position{pos});
+  float angle = rnd(-180.f, 180.f);
+  ecs.addComponent(e, Rotation{angle, 0.f});
+  ecs.addComponent(e, Orientation{angle});
+  ecs.addComponent(e, Collision{e, ShapeType::AABB, type, 0, halfWidth, halfHeight, 0.f});
+  return e;
+}
+
+// 30 asteroids, 4 ships and rounds PDC rounds and a torpedo for every 20
+// rounds, the rounds in clouds round the ships
+void populate(Coordinator &ecs, std::size_t rounds) {
+  std::srand(1);
+  for (int i = 0; i < 30; ++i) {
+    float size = rnd(1.f, 5.f);
+    collider(ecs, {rnd(-200000.f, 200000.f), rnd(-40000.f, -20000.f)}, CollisionType::ASTEROID,
+             716.f * size * 0.75f / 2, 589.f * size * 0.75f / 2);
+  }
+
+  const sf::Vector2f ships[] = {{0.f, 0.f}, {14000.f, -28000.f}, {-50000.f, -28000.f}, {-30000.f, -30000.f}};
+  for (sf::Vector2f ship : ships) {
+    collider(ecs, ship, CollisionType::SHIP, 343.f, 133.f);
+  }
+
+  for (std::size_t i = 0; i < rounds; ++i) {
+    sf::Vector2f around = ships[i % 4] + sf::Vector2f{rnd(-20000.f, 20000.f), rnd(-20000.f, 20000.f)};
+    collider(ecs, around, CollisionType::PROJECTILE, 70.f, 70.f);
+    if (i % 20 == 0) {
+      collider(ecs, around + sf::Vector2f{rnd(-3000.f, 3000.f), rnd(-3000.f, 3000.f)}, CollisionType::TORPEDO, 100.f,
+               30.f);
+    }
+  }
+}
+
+sf::Vector2f extentOf(Coordinator &ecs, Entity e) {
+  return CollisionSystem::broadphaseExtent(ecs.getComponent<Collision>(e), ecs.getComponent<Orientation>(e));
+}
+
+bool overlap(sf::Vector2f p1, sf::Vector2f e1, sf::Vector2f p2, sf::Vector2f e2) {
+  return p1.x - e1.x < p2.x + e2.x && p1.x + e1.x > p2.x - e2.x && p1.y - e1.y < p2.y + e2.y &&
+         p1.y + e1.y > p2.y - e2.y;
+}
+
+struct Result {
+  std::size_t tested = 0;
+  std::vector<std::pair<Entity, Entity>> hits;
+};
+
+// the old check, every entity against every other
+Result bruteForce(Coordinator &ecs) {
+  Result r;
+  auto &colliders = ecs.group<Collision>();
+  for (Entity e : colliders) {
+    sf::Vector2f pos = ecs.getComponent<Position>(e).value;
+    sf::Vector2f extent = extentOf(ecs, e);
+    for (Entity other : colliders) {
+      if (e == other)
+        continue;
+      ++r.tested;
+      if (overlap(pos, extent, ecs.getComponent<Position>(other).value, extentOf(ecs, other))) {
+        r.hits.push_back({e, other});
+      }
+    }
+  }
+  return r;
+}
+
+// the spatial hash, rebuilt like every tick
+Result grid(Coordinator &ecs, SpatialHash &hash) {
+  Result r;
+  auto &colliders = ecs.group<Collision>();
+  hash.clear();
+  for (std::uint32_t i = 0; i < colliders.size(); ++i) {
+    sf::Vector2f pos = ecs.getComponent<Position>(colliders[i]).value;
+    sf::Vector2f extent = extentOf(ecs, colliders[i]);
+    hash.insert(i, pos - extent, pos + extent);
+  }
+  hash.build();
+
+  std::vector<std::uint32_t> nearby;
+  for (std::uint32_t i = 0; i < colliders.size(); ++i) {
+    Entity e = colliders[i];
+    sf::Vector2f pos = ecs.getComponent<Position>(e).value;
+    sf::Vector2f extent = extentOf(ecs, e);
+    hash.candidates(i, nearby);
+    for (std::uint32_t j : nearby) {
+      Entity other = colliders[j];
+      ++r.tested;
+      if (overlap(pos, extent, ecs.getComponent<Position>(other).value, extentOf(ecs, other))) {
+        r.hits.push_back({e, other});
+      }
+    }
+  }
+  return r;
+}
+
+// the cells a few at a time on the pool, per worker buffers merged and sorted
+using Contacts = std::vector<std::pair<std::uint32_t, std::uint32_t>>;
+struct Detection {
+  Contacts contacts;
+};
+
+Contacts detect(Coordinator &ecs, const SpatialHash &hash, ThreadPool &pool, std::vector<Detection> &detections) {
+  auto &colliders = ecs.group<Collision>();
+  detections.resize(pool.size());
+  for (auto &d : detections) {
+    d.contacts.clear();
+  }
+
+  std::size_t grain = std::max<std::size_t>(hash.cells() / (pool.size() * 4), 64);
+  pool.parallelFor(hash.cells(), grain, [&](std::size_t begin, std::size_t end) {
+    Detection &d = detections[ThreadPool::currentWorker()];
+    for (std::size_t cell = begin; cell < end; ++cell) {
+      hash.eachPairInCell(cell, [&](std::uint32_t a, std::uint32_t b) {
+        Entity e1 = colliders[a];
+        Entity e2 = colliders[b];
+        auto &c1 = ecs.getComponent<Collision>(e1);
+        auto &c2 = ecs.getComponent<Collision>(e2);
+        if (CollisionSystem::OBBCollision(ecs.getComponent<Position>(e1).value, ecs.getComponent<Orientation>(e1),
+                                          c1.halfWidth, c1.halfHeight, ecs.getComponent<Position>(e2).value,
+                                          ecs.getComponent<Orientation>(e2), c2.halfWidth, c2.halfHeight)) {
+          d.contacts.push_back({a, b});
+        }
+      });
+    }
+  });
+
+  Contacts contacts;
+  for (auto &d : detections) {
+    contacts.insert(contacts.end(), d.contacts.begin(), d.contacts.end());
+  }
+  std::sort(contacts.begin(), contacts.end());
+  return contacts;
+}
+
+// milliseconds per run
+template <typename Fn> double time(int runs, Fn &&fn) {
+  auto start = std::chrono::steady_clock::now();
+  for (int i = 0; i < runs; ++i) {
+    fn();
+  }
+  return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count() / runs;
+}
+
+} // namespace
+
+int main() {
+  std::cout << std::setw(10) << "colliders" << std::setw(14) << "full pairs" << std::setw(14) << "grid pairs"
+            << std::setw(10) << "overlaps" << std::setw(12) << "full ms" << std::setw(12) << "grid ms\n";
+
+  for (std::size_t rounds : {100u, 500u, 2000u, 8000u}) {
+    auto ecs = std::make_unique<Coordinator>();
+    populate(*ecs, rounds);
+    SpatialHash hash;
+
+    Result full = bruteForce(*ecs);
+    Result cells = grid(*ecs, hash);
+
+    int runs = static_cast<int>(20000000 / (full.tested + 1)) + 1;
+    double fullMs = time(runs, [&] { bruteForce(*ecs); });
+    double gridMs = time(runs * 10, [&] { grid(*ecs, hash); });
+
+    std::cout << std::setw(10) << ecs->group<Collision>().size() << std::setw(14) << full.tested << std::setw(14)
+              << cells.tested << std::setw(10) << full.hits.size() << std::fixed << std::setprecision(3)
+              << std::setw(12) << fullMs << std::setw(12) << gridMs
+              << (full.hits == cells.hits ? "" : "   MISSED PAIRS") << "\n";
+  }
+
+  unsigned cores = std::max(std::thread::hardware_concurrency(), 1u);
+  ThreadPool one(1), all(cores);
+  std::cout << "\n" << std::setw(10) << "colliders" << std::setw(10) << "cells" << std::setw(10) << "contacts"
+            << std::setw(12) << "1 thread" << std::setw(10) << cores << " threads (ms)\n";
+
+  for (std::size_t rounds : {2000u, 8000u, 32000u}) {
+    auto ecs = std::make_unique<Coordinator>();
+    populate(*ecs, rounds);
+    SpatialHash hash;
+    grid(*ecs, hash);
+    std::vector<Detection> detections;
+
+    Contacts serial = detect(*ecs, hash, one, detections);
+    Contacts parallel = detect(*ecs, hash, all, detections);
+
+    double serialMs = time(20, [&] { detect(*ecs, hash, one, detections); });
+    double parallelMs = time(20, [&] { detect(*ecs, hash, all, detections); });
+
+    std::cout << std::setw(10) << ecs->group<Collision>().size() << std::setw(10) << hash.cells() << std::setw(10)
+              << serial.size() << std::fixed << std::setprecision(3) << std::setw(12) << serialMs << std::setw(10) << parallelMs
+              << (serial == parallel ? "" : "   DIFFERENT CONTACTS") << "\n";
+  }
+}
@@ -0,0 +1,108 @@
+// Kinematics benchmark: the old three pass physics (A->V, V->P, rotation)
+// against the fused pass, and the SIMD kernel on its own. Prints the
+// throughput in entities per microsecond. The fused pass only exists for
+// the archetype storage, configure with -DROCI_ECS_ARCHETYPE=ON to see it.
+// With the sparse sets updateKinematics() runs the three passes itself.
+//
+//   cmake -S . -B build -DCMAKE_BUILD_TYPE=Release -DROCI_BUILD_BENCHMARKS=ON
+//   cmake --build build --target bench_kinematics && ./build/bin/bench_kinematics
+#include "../include/components.hpp"
+#include "../include/ecs.hpp"
+#include "../include/kinematics.hpp"
+#include <chrono>
+#include <cstdlib>
+#include <iomanip>
+#include <iostream>
+#include <memory>
+#include <vector>
+
+namespace {
+
+const float dt = 1.f / 60.f;
+
+// n entities, like the game a few in ten accelerate (ships, torpedoes) and
+// the rest coast (bullets, asteroids)
+void populate(Coordinator &ecs, std::size_t n) {
+  std::srand(1);
+  auto r = [] { return static_cast<float>(std::rand()) / RAND_MAX * 2.f - 1.f; };
+
+  for (std::size_t i = 0; i < n; ++i) {
+    Entity e = ecs.createEntity();
+    ecs.addComponent(e, Position{{r() * 1000.f, r() * 1000.f}});
+    ecs.addComponent(e, Velocity{{r() * 100.f, r() * 100.f}});
+    ecs.addComponent(e, Rotation{r() * 180.f, r() * 20.f});
+    if (i % 10 < 3) {
+      ecs.addComponent(e, Acceleration{{r() * 10.f, r() * 10.f}});
+    }
+  }
+}
+
+void threePass(Coordinator &ecs) {
+  ecs.parallelEach<Velocity, Acceleration>([](Entity, Velocity &vel, Acceleration &acc) { vel.value += acc.value * dt; });
+  ecs.parallelEach<Position, Velocity>([](Entity, Position &pos, Velocity &vel) { pos.value += vel.value * dt; });
+  ecs.parallelEach<Rotation>([](Entity, Rotation &rot) { rot.angle = rot.angle + rot.angularVelocity * dt; });
+}
+
+void fused(Coordinator &ecs) { updateKinematics(ecs, dt); }
+
+// entities per microsecond over frames runs of update
+template <typename Fn> double throughput(std::size_t n, int frames, Fn &&update) {
+  update(); // warm up, registers the groups
+  auto start = std::chrono::steady_clock::now();
+  for (int f = 0; f < frames; ++f) {
+    update();
+  }
+  double us = std::chrono::duration<double, std::micro>(std::chrono::steady_clock::now() - start).count();
+  return static_cast<double>(n) * frames / us;
+}
+
+} // namespace
+
+int main() {
+#if defined(__AVX2__)
+  const char *isa = "AVX2";
+#elif defined(__SSE2__) || defined(_M_X64)
+  const char *isa = "SSE2";
+#else
+  const char *isa = "scalar";
+#endif
+#if defined(ROCI_ECS_ARCHETYPE)
+  const char *storage = "archetype";
+#else
+  const char *storage = "sparse set";
+#endif
+  std::cout << "kinematics kernel: " << isa << ", " << storage << " storage\n";
+  std::cout << std::setw(10) << "entities" << std::setw(14) << "three pass" << std::setw(14) << "fused"
+            << std::setw(14) << "kernel only" << "   (entities/us)\n";
+
+  for (std::size_t n : {1000u, 10000u, 100000u}) {
+    int frames = static_cast<int>(2000000 / n) + 10;
+
+    // separate worlds so both start from the same state
+    auto a = std::make_unique<Coordinator>();
+    auto b = std::make_unique<Coordinator>();
+    populate(*a, n);
+    populate(*b, n);
+
+    double old = throughput(n, frames, [&] { threePass(*a); });
+    double now = throughput(n, frames, [&] { fused(*b); });
+
+    // the kernel alone, on plain arrays
+    std::vector<Position> pos(n);
+    std::vector<Velocity> vel(n, Velocity{{1.f, 1.f}});
+    std::vector<Acceleration> acc(n, Acceleration{{0.5f, 0.5f}});
+    std::vector<Rotation> rot(n, Rotation{0.f, 1.f});
+    double kernel = throughput(n, frames, [&] { integrateKinematics(n, pos.data(), vel.data(), acc.data(), rot.data(), dt); });
+
+    // both ran the same number of frames, so they must agree exactly
+    bool same = true;
+    for (Entity e : a->group<Position, Velocity>()) {
+      const Position &pa = a->getComponent<Position>(e);
+      const Position &pb = b->getComponent<Position>(e);
+      same = same && pa.value == pb.value && a->getComponent<Rotation>(e).angle == b->getComponent<Rotation>(e).angle;
+    }
+
+    std::cout << std::setw(10) << n << std::fixed << std::setprecision(1) << std::setw(14) << old << std::setw(14)
+              << now << std::setw(14) << kernel << (same ? "" : "   MISMATCH") << "\n";
+  }
+}
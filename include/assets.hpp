@@ -0,0 +1,109 @@
+#pragma once
+#include <SFML/Graphics/Image.hpp>
+#include <SFML/Graphics/Texture.hpp>
+#include <SFML/System/Vector2.hpp>
+#include <iostream>
+#include <optional>
+#include <string>
+
+#if !defined(ROCI_HEADLESS)
+#include <SFML/Audio/Sound.hpp>
+#include <SFML/Audio/SoundBuffer.hpp>
+#endif
+
+///////////////////////////////////////////////////////////////////////////////
+// ASSETS
+///////////////////////////////////////////////////////////////////////////////
+// The textures and sounds from assets/. The sim only needs the texture sizes
+// (sprite origins, collision boxes). The headless build (roci-sim, built with
+// ROCI_HEADLESS) reads just the image sizes, never creates a texture and has
+// no audio at all, so it runs without a display or a sound device.
+
+struct TextureAsset {
+  sf::Texture texture; // empty when headless
+  sf::Vector2u size;
+
+  bool load(const std::string &path, bool headless) {
+    if (headless) {
+      sf::Image image;
+      if (!image.loadFromFile(path))
+        return false;
+      size = image.getSize();
+      return true;
+    }
+
+    if (!texture.loadFromFile(path))
+      return false;
+    size = texture.getSize();
+    return true;
+  }
+};
+
+// a sound the sim can trigger, silent until it's given a sound to play (and
+// always silent in the headless build)
+class SoundEffect {
+public:
+#if defined(ROCI_HEADLESS)
+  void play() {}
+#else
+  void play() {
+    if (sound)
+      sound->play();
+  }
+
+  void set(sf::Sound &playWith) { sound = &playWith; }
+
+private:
+  sf::Sound *sound = nullptr;
+#endif
+};
+
+struct Assets {
+  TextureAsset roci, belterFrigate, pella, bullet, torpedo, explosion, drive, pellaDrive, asteroid;
+  SoundEffect pdcFire, pdcHit, explosionSound;
+
+  Assets() = default;
+  Assets(const Assets &) = delete; // the sound effects point at the players below
+  Assets &operator=(const Assets &) = delete;
+
+  // false (and the reason on stdout) if anything is missing
+  bool load(bool headless) {
+    const std::string textures = "../assets/textures/";
+    const std::pair<TextureAsset *, const char *> files[] = {
+        {&roci, "roci.png"},       {&belterFrigate, "bashi-bazouk.png"}, {&pella, "pella.png"},
+        {&bullet, "pdc-bullet.png"}, {&torpedo, "torpedo.png"},          {&explosion, "explosion_sheet.png"},
+        {&drive, "drive.png"},     {&pellaDrive, "pella-drive.png"},     {&asteroid, "asteroid-1.png"}};
+
+    for (auto &[asset, file] : files) {
+      if (!asset->load(textures + file, headless)) {
+        std::cout << "Error loading texture " << file << std::endl;
+        return false;
+      }
+    }
+
+#if !defined(ROCI_HEADLESS)
+    if (!headless) {
+      const std::string sounds = "../assets/sounds/";
+      if (!pdcFireBuffer.loadFromFile(sounds + "pdc.wav") || !pdcHitBuffer.loadFromFile(sounds + "pdc-hit.wav") ||
+          !explosionBuffer.loadFromFile(sounds + "explosion.wav")) {
+        std::cout << "Error loading sound" << std::endl;
+        return false;
+      }
+
+      pdcFirePlayer.emplace(pdcFireBuffer);
+      pdcHitPlayer.emplace(pdcHitBuffer);
+      explosionPlayer.emplace(explosionBuffer);
+      pdcFire.set(*pdcFirePlayer);
+      pdcHit.set(*pdcHitPlayer);
+      explosionSound.set(*explosionPlayer);
+    }
+#endif
+    return true;
+  }
+
+private:
+#if !defined(ROCI_HEADLESS)
+  sf::SoundBuffer pdcFireBuffer, pdcHitBuffer, explosionBuffer;
+  std::optional<sf::Sound> pdcFirePlayer, pdcHitPlayer, explosionPlayer;
+#endif
+};
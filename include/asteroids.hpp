@@ -1,101 +1,101 @@
 
 #pragma once
 
+#include "assets.hpp"
 #include "ecs.hpp"
+#include "random.hpp"
 #include "components.hpp"
 #include "utils.hpp"
-#include <SFML/Graphics/Texture.hpp>
+#include <array>
 #include <cstdint>
+#include <tuple>
 
 class AsteroidFactory {
 public:
-  AsteroidFactory(Coordinator &ecs) : ecs(ecs) {
-
-    if (!mediumAsteroidTexture.loadFromFile("../assets/textures/asteroid-1.png")) {
-
-      std::cout << "Error loading texture" << std::endl;
-      std::exit(-1);
-    }
-
-    // seed random number generator
-    std::srand(static_cast<unsigned int>(std::time(nullptr)));
-  }
+  // seed is the Simulation's, the asteroids draw from their own stream of it
+  AsteroidFactory(Coordinator &ecs, const TextureAsset &texture, std::uint64_t seed) :
+    ecs(ecs), mediumAsteroidTexture(texture), rng(seed, RngStream::ASTEROIDS),
+    asteroidName(ecs.internName("Asteroid")) {}
 
   virtual ~AsteroidFactory() = default;
 
   void createInitialAsteroids() {
 
     // too many asteroids will cause performance issues
-    for (int a = 0; a < 30; ++a) {
-      float size = randFloat(1.0f, 5.0f);
-      float posX = randFloat(-200000.f, 200000.f);
-      float posY = randFloat(-20000.f, -40000.f);  // so it wont be on the player
-      float velX = randFloat(-250.f, 250.f);
-      float velY = randFloat(-250.f, 250.f);
-      float rot  = randFloat(-180.f, 180.f);
-      float av   = randFloat(-20.f, 20.f);
-
-      createAsteroid(mediumAsteroidTexture, "Asteroid", size,
-                     {posX, posY},
-                     {velX, velY},
-                     rot,
-                     av, 2000);
-    }
+    ecs.spawn(30, asteroidName, [&](std::size_t, Entity e) {
+      AsteroidParams a;
+      a.size = rng.uniform(1.0f, 5.0f);
+      float posX = rng.uniform(-200000.f, 200000.f);
+      float posY = rng.uniform(-20000.f, -40000.f);  // so it wont be on the player
+      a.position = {posX, posY};
+      float velX = rng.uniform(-250.f, 250.f);
+      float velY = rng.uniform(-250.f, 250.f);
+      a.velocity = {velX, velY};
+      a.rotation = rng.uniform(-180.f, 180.f);
+      a.angularVelocity = rng.uniform(-20.f, 20.f);
+
+      return asteroidComponents(e, a);
+    });
   }
 
+  // called from the collision handlers, so the debris is queued on the
+  // command buffer and appears at the next ecs.flush()
   void createDebrisAsteroids(sf::Vector2f position) {
 
-    for (int a = 0; a < randInt(1,3); ++a) {
-      float size = randFloat(0.25f, 0.8f);
-      auto newpos = position + sf::Vector2f{randFloat(-1000.f, 1000.f), randFloat(-1000.f, 1000.f)};
+    std::array<AsteroidParams, 3> debris;
+    std::size_t count = 0;
 
-      float velY = randFloat(-5000.f, 5000.f);
-      float velX = randFloat(-5000.f, 5000.f);
-      float rot  = randFloat(-180.f, 180.f);
-      float av   = randFloat(-140.f, 140.f);
+    for (int a = 0; a < rng.range(1, 3); ++a) {
+      AsteroidParams &d = debris[count++];
+      d.size = rng.uniform(0.25f, 0.8f);
+      d.position = position + sf::Vector2f{rng.uniform(-1000.f, 1000.f), rng.uniform(-1000.f, 1000.f)};
 
-      createAsteroid(mediumAsteroidTexture, "Asteroid", size,
-                     newpos,
-                     {velX, velY},
-                     rot,
-                     av, 2000);
+      float velY = rng.uniform(-5000.f, 5000.f);
+      float velX = rng.uniform(-5000.f, 5000.f);
+      d.velocity = {velX, velY};
+      d.rotation = rng.uniform(-180.f, 180.f);
+      d.angularVelocity = rng.uniform(-140.f, 140.f);
     }
+
+    ecs.commands().spawn(count, asteroidName, [this, debris](std::size_t i, Entity e) {
+      return asteroidComponents(e, debris[i]);
+    });
   }
 
 
 private:
     Coordinator &ecs;
-    sf::Texture mediumAsteroidTexture;
-
-  // Create an asteroid entity
-  Entity createAsteroid(sf::Texture &asteroidTexture, const std::string &name, float scale, sf::Vector2f position,
-                        sf::Vector2f velocity, float rotation, float angularVelocity, int32_t health) {
-    Entity e = ecs.createEntity(name);
-    ecs.addComponent(e, Position{position});
-    ecs.addComponent(e, Velocity{velocity});
-    ecs.addComponent(e, Rotation{rotation, angularVelocity}); // Initial rotation
-    ecs.addComponent(e, Health{health});
-    SpriteComponent sc{sf::Sprite(asteroidTexture)};
-    sf::Vector2f asteroidOrigin(asteroidTexture.getSize().x / 2.f,
-                                asteroidTexture.getSize().y / 2.f);
+    const TextureAsset &mediumAsteroidTexture;
+    Rng rng;
+    NameId asteroidName;
+
+  struct AsteroidParams {
+    float size = 1.f;
+    sf::Vector2f position;
+    sf::Vector2f velocity;
+    float rotation = 0.f;
+    float angularVelocity = 0.f;
+    int32_t health = 2000;
+  };
+
+  using AsteroidComponents = std::tuple<Position, Velocity, Rotation, Orientation, Health, SpriteComponent, Collision>;
+
+  // the components of asteroid e, for ecs.spawn()
+  AsteroidComponents asteroidComponents(Entity e, const AsteroidParams &a) const {
+    SpriteComponent sc{sf::Sprite(mediumAsteroidTexture.texture)};
+    sf::Vector2f asteroidOrigin(mediumAsteroidTexture.size.x / 2.f,
+                                mediumAsteroidTexture.size.y / 2.f);
     sc.sprite.setOrigin(asteroidOrigin);
-    sc.sprite.setScale(sf::Vector2f{scale, scale});
-    ecs.addComponent(e, sc);
+    sc.sprite.setScale(sf::Vector2f{a.size, a.size});
 
     // scale is to make sure the collision box is slightly smaller than the sprite
-    ecs.addComponent(e, Collision{e, ShapeType::AABB,
-                                  CollisionType::ASTEROID,
-                                  100, // damage
-                                  static_cast<float>(asteroidTexture.getSize().x * scale * 0.75f) / 2,
-                                  static_cast<float>(asteroidTexture.getSize().y * scale * 0.75f) / 2, 0.f});
-
-    // std::cout << "Created asteroid: " << name << " with texture size: "
-    //           << asteroidTexture.getSize().x * scale << "x" << asteroidTexture.getSize().y * scale
-    //           << " with velocity: " << velocity.x << ", " << velocity.y
-    //           << " with rotation: " << rotation
-    //           << " at position: " << position.x << ", " << position.y << std::endl;
-
-    return e;
+    Collision collision{e, ShapeType::AABB,
+                        CollisionType::ASTEROID,
+                        100, // damage
+                        static_cast<float>(mediumAsteroidTexture.size.x * a.size * 0.75f) / 2,
+                        static_cast<float>(mediumAsteroidTexture.size.y * a.size * 0.75f) / 2, 0.f};
+
+    return {Position{a.position}, Velocity{a.velocity}, Rotation{a.rotation, a.angularVelocity},
+            Orientation{a.rotation}, Health{a.health}, sc, collision};
   }
 };
-
@@ -1,5 +1,6 @@
 #pragma once
 #include "ecs.hpp"
+#include "assets.hpp"
 #include "components.hpp"
 #include "utils.hpp"
 #include <SFML/Graphics.hpp>
@@ -12,7 +13,7 @@
 class BallisticsFactory {
 public:
   // Constructor cannot be declared virtual 
-  BallisticsFactory(Coordinator &ecs, sf::Texture texture) :
+  BallisticsFactory(Coordinator &ecs, const TextureAsset &texture) :
     ecs(ecs),
     texture(texture) {
     std::cout << "BallisticsFactory created" << std::endl;
@@ -25,7 +26,7 @@ public:
 
 protected:  
   Coordinator &ecs;
-  sf::Texture texture;
+  const TextureAsset &texture;
 };
 
 // use this as a temporary fix to stop bullets colliding with the ship that
@@ -35,88 +36,93 @@ const uint32_t launch_distance = 500;
 
 class BulletFactory : public BallisticsFactory {
 public:
-  BulletFactory(Coordinator &ecs, sf::Texture &texture) : BallisticsFactory(ecs, texture) {
+  BulletFactory(Coordinator &ecs, const TextureAsset &texture) :
+    BallisticsFactory(ecs, texture), bulletName(ecs.internName("Bullet")) {
     std::cout << "BulletFactory created" << std::endl;
   }
   ~BulletFactory() override = default;
 
   void fireone(Entity firedby, Entity pdcEntity, float timeFired) {
+    fire(firedby, &pdcEntity, 1, timeFired);
+  }
 
-    Entity bullet = ecs.createEntity("Bullet");
- 
-    auto &pdc = ecs.getComponent<Pdc>(pdcEntity);
+  // one round from each of count pdcs, spawned as one batch so a burst only
+  // grows the component arrays once
+  void fire(Entity firedby, const Entity *pdcEntities, std::size_t count, float timeFired) {
     auto pvel = ecs.getComponent<Velocity>(firedby);
     auto ppos = ecs.getComponent<Position>(firedby);
-    auto prot = ecs.getComponent<Rotation>(firedby);
-
-    // fire pdc out at an angle, convert to radians
-    // float dx = std::cos((prot.angle + pdc.firingAngle) * (M_PI / 180.f));
-    // float dy = std::sin((prot.angle + pdc.firingAngle) * (M_PI / 180.f));
-
-    // the firing angle is an absolute angle, so we need to use it directly
-    float dx = std::cos((pdc.firingAngle) * (M_PI / 180.f));
-    float dy = std::sin((pdc.firingAngle) * (M_PI / 180.f));
-
-    ecs.addComponent(
-        bullet, Velocity{{pvel.value.x + (dx * pdc.projectileSpeed),
-                          pvel.value.y + (dy * pdc.projectileSpeed)}});
-
-    // fire from the actual pdc, not the centre of the ship
-    sf::Vector2f pdcOffset = rotateVector({pdc.positionx, pdc.positiony}, prot.angle);
-    ecs.addComponent(
-        bullet, Position{ppos.value + pdcOffset});
-
-    ecs.addComponent(bullet, Rotation{pdc.firingAngle});
-    ecs.addComponent(bullet, Collision{firedby, ShapeType::AABB,
-                                       CollisionType::PROJECTILE, pdc.projectileDamage,
-                                       70.0f, 70.0f, 0.f});
-    ecs.addComponent(bullet, TimeFired{timeFired});
-
-    SpriteComponent sc{sf::Sprite(texture)};
-    sf::Vector2f bulletOrigin(texture.getSize().x / 2.f,
-                              texture.getSize().y / 2.f);
+    Orientation orientation = currentOrientation(ecs, firedby); // a copy, the spawn grows the arrays
+
+    SpriteComponent sc{sf::Sprite(texture.texture)};
+    sf::Vector2f bulletOrigin(texture.size.x / 2.f,
+                              texture.size.y / 2.f);
     sc.sprite.setOrigin(bulletOrigin);
-    ecs.addComponent(bullet, sc);
+
+    ecs.spawn(count, bulletName, [&](std::size_t i, Entity) {
+      auto &pdc = ecs.getComponent<Pdc>(pdcEntities[i]);
+
+      // fire pdc out at an angle, convert to radians
+      // float dx = std::cos((prot.angle + pdc.firingAngle) * (M_PI / 180.f));
+      // float dy = std::sin((prot.angle + pdc.firingAngle) * (M_PI / 180.f));
+
+      // the firing angle is an absolute angle, so we need to use it directly
+      float dx = std::cos((pdc.firingAngle) * (M_PI / 180.f));
+      float dy = std::sin((pdc.firingAngle) * (M_PI / 180.f));
+
+      // fire from the actual pdc, not the centre of the ship
+      sf::Vector2f pdcOffset = orientation.rotate({pdc.positionx, pdc.positiony});
+
+      return std::make_tuple(
+          Velocity{{pvel.value.x + (dx * pdc.projectileSpeed),
+                    pvel.value.y + (dy * pdc.projectileSpeed)}},
+          Position{ppos.value + pdcOffset},
+          Rotation{pdc.firingAngle},
+          Orientation{pdc.firingAngle},
+          Collision{firedby, ShapeType::AABB,
+                    CollisionType::PROJECTILE, pdc.projectileDamage,
+                    70.0f, 70.0f, 0.f},
+          TimeFired{timeFired},
+          sc);
+    });
   }
 
   void Update(float tt) {
     // This method can be used to update the bullet factory 
     // to remove bullets that have been fired for too long
-    for (auto &entity : ecs.view<TimeFired>()) {
+    // backwards, destroying a bullet moves the last one into its place
+    auto &bullets = ecs.group<TimeFired>();
+    for (std::size_t i = bullets.size(); i-- > 0;) {
+      Entity entity = bullets[i];
       auto &timeFired = ecs.getComponent<TimeFired>(entity);
 
+      // destroying the bullet drops all of its components
       if (tt - timeFired.value > 10.0f) {
-        ecs.removeComponent<Velocity>(entity);
-        ecs.removeComponent<Position>(entity);
-        ecs.removeComponent<Rotation>(entity);
-        ecs.removeComponent<Collision>(entity);
-        ecs.removeComponent<TimeFired>(entity);
-        ecs.removeComponent<SpriteComponent>(entity);
         ecs.destroyEntity(entity);
         // std::cout << "Bullet " << entity << " removed" << std::endl;
       }
     }
   }
+private:
+  NameId bulletName;
 };
 
 class TorpedoFactory : public BallisticsFactory {
 public:
-  TorpedoFactory(Coordinator &ecs, sf::Texture &texture) : BallisticsFactory(ecs, texture) {
+  TorpedoFactory(Coordinator &ecs, const TextureAsset &texture) :
+    BallisticsFactory(ecs, texture), torpedoName(ecs.internName("Torpedo")) {
     std::cout << "TorpedoFactory created" << std::endl;
   }
   ~TorpedoFactory() override = default;
 
+  // a torpedo gets all of its components in one spawn, with the archetype
+  // storage that's one move into its chunk instead of one per component
   template<typename Weapon>
   void fireone(Entity firedby, Entity target) {
-    Entity torpedo = ecs.createEntity("Torpedo");
- 
-    auto &launcher = ecs.getComponent<Weapon>(firedby);
+    auto launcher = ecs.getComponent<Weapon>(firedby); // copies, the spawn grows the arrays
     auto svel = ecs.getComponent<Velocity>(firedby); // s for source
     auto spos = ecs.getComponent<Position>(firedby);
     auto srot = ecs.getComponent<Rotation>(firedby);
 
-    ecs.addComponent(torpedo, TorpedoTarget{target});
-
     // fire launcher out at an angle, convert to radians
     // add an offset to fire on the left or right of the ship
     float dx = std::cos((srot.angle + launcher.firingAngle) * (M_PI / 180.f));
@@ -131,33 +137,40 @@ public:
     float wx = spos.value.x + dx * (launch_distance + 150.f) + perp_dx * launcher.firingOffset;
     float wy = spos.value.y + dy * (launch_distance + 150.f) + perp_dy * launcher.firingOffset;
 
-    // the velocity of the torpedo is the velocity of the launcher plus the projectile speed
-    ecs.addComponent(
-        torpedo, Velocity{{svel.value.x + (dx * launcher.projectileSpeed),
-                           svel.value.y + (dy * launcher.projectileSpeed)}});
+    SpriteComponent sc{sf::Sprite(texture.texture)};
+    sf::Vector2f torpedoOrigin(texture.size.x / 2.f,
+                               texture.size.y / 2.f);
+    sc.sprite.setOrigin(torpedoOrigin);
 
-    // want launcher1 to be seperated from launcher2
-    ecs.addComponent(torpedo, Position{{wx, wy}}); 
+    ecs.spawn(1, torpedoName, [&](std::size_t, Entity) {
+      return std::make_tuple(
+          TorpedoTarget{target},
 
-    ecs.addComponent(torpedo, Rotation{srot.angle + launcher.firingAngle});
+          // the velocity of the torpedo is the velocity of the launcher plus the projectile speed
+          Velocity{{svel.value.x + (dx * launcher.projectileSpeed),
+                    svel.value.y + (dy * launcher.projectileSpeed)}},
 
-    // accelerate the torpedo out
-    ecs.addComponent(torpedo, Acceleration{{(dx * launcher.projectileAccel),
-                                            (dy * launcher.projectileAccel)}});
+          // want launcher1 to be seperated from launcher2
+          Position{{wx, wy}},
 
-    // TODO: collision size is a guess atm
-    ecs.addComponent(torpedo, Collision{firedby, ShapeType::AABB,
-                                        CollisionType::TORPEDO, launcher.projectileDamage,
-                                        100.0f, 30.f, 0.f});
+          Rotation{srot.angle + launcher.firingAngle},
+          Orientation{srot.angle + launcher.firingAngle},
 
-    // each torpedo has it's own control structure
-    ecs.addComponent(torpedo, TorpedoControl{});
+          // accelerate the torpedo out
+          Acceleration{{(dx * launcher.projectileAccel),
+                        (dy * launcher.projectileAccel)}},
 
-    SpriteComponent sc{sf::Sprite(texture)};
-    sf::Vector2f torpedoOrigin(texture.getSize().x / 2.f,
-                               texture.getSize().y / 2.f);
-    sc.sprite.setOrigin(torpedoOrigin);
-    ecs.addComponent(torpedo, sc);
+          // TODO: collision size is a guess atm
+          Collision{firedby, ShapeType::AABB,
+                    CollisionType::TORPEDO, launcher.projectileDamage,
+                    100.0f, 30.f, 0.f},
+
+          // each torpedo has it's own control structure
+          TorpedoControl{},
+          sc);
+    });
   }
+private:
+  NameId torpedoName;
 };
 
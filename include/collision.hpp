@@ -1,23 +1,77 @@
 #pragma once
+#include "assets.hpp"
 #include "components.hpp"
 #include "ecs.hpp"
 #include "explosion.hpp"
 #include "utils.hpp"
 #include "asteroids.hpp"
-#include <SFML/Audio/SoundBuffer.hpp>
+#include "spatialhash.hpp"
 #include <SFML/Graphics/Texture.hpp>
 #include <SFML/System/Vector2.hpp>
-#include <SFML/Audio.hpp>
-#include <functional>
+#include <algorithm>
+#include <array>
+#include <cassert>
 #include <cmath>
+#include <cstdint>
+#include <iostream>
+#include <utility>
+#include <vector>
+
+///////////////////////////////////////////////////////////////////////////////
+// COLLISION MATRIX
+///////////////////////////////////////////////////////////////////////////////
+// Which collision types interact. Each type is a layer bit and its mask is
+// the layers it collides with, a pair that isn't in here is thrown out
+// before any geometry test: PDC rounds pass through each other, torpedoes
+// pass through each other and ships don't bump (the bounce made them stick).
+constexpr std::size_t COLLISION_TYPES = 4;
+
+constexpr std::size_t collisionIndex(CollisionType type) { return static_cast<std::size_t>(type); }
+
+constexpr std::uint8_t collisionLayer(CollisionType type) {
+  return static_cast<std::uint8_t>(1u << collisionIndex(type));
+}
+
+constexpr std::array<std::uint8_t, COLLISION_TYPES> COLLISION_MASKS = {
+    // SHIP
+    collisionLayer(CollisionType::PROJECTILE) | collisionLayer(CollisionType::TORPEDO) |
+        collisionLayer(CollisionType::ASTEROID),
+    // PROJECTILE
+    collisionLayer(CollisionType::SHIP) | collisionLayer(CollisionType::TORPEDO) |
+        collisionLayer(CollisionType::ASTEROID),
+    // TORPEDO
+    collisionLayer(CollisionType::SHIP) | collisionLayer(CollisionType::PROJECTILE) |
+        collisionLayer(CollisionType::ASTEROID),
+    // ASTEROID
+    collisionLayer(CollisionType::SHIP) | collisionLayer(CollisionType::PROJECTILE) |
+        collisionLayer(CollisionType::TORPEDO) | collisionLayer(CollisionType::ASTEROID),
+};
+
+constexpr bool collides(CollisionType a, CollisionType b) {
+  return (COLLISION_MASKS[collisionIndex(a)] & collisionLayer(b)) != 0;
+}
+
+// every pair is only tested once, so a hitting b has to mean b hits a
+constexpr bool collisionMatrixSymmetric() {
+  for (std::size_t a = 0; a < COLLISION_TYPES; ++a) {
+    for (std::size_t b = 0; b < COLLISION_TYPES; ++b) {
+      if (collides(CollisionType(a), CollisionType(b)) != collides(CollisionType(b), CollisionType(a)))
+        return false;
+    }
+  }
+  return true;
+}
+static_assert(collisionMatrixSymmetric(), "the collision matrix must be symmetric");
 
 class CollisionSystem {
 public:
-  using CollisionHandler  = std::function<void(Entity, Entity)>;
+  // handles one unordered pair of types, the entity with the lower
+  // CollisionType comes first
+  using CollisionHandler = void (CollisionSystem::*)(Entity, Entity);
 
   CollisionSystem(Coordinator &ecs,
-                  sf::Sound &pdcHitSoundPlayer,
-                  sf::Sound &explosionSoundPlayer,
+                  SoundEffect &pdcHitSoundPlayer,
+                  SoundEffect &explosionSoundPlayer,
                   std::vector<Explosion> &explosions,
                   sf::Texture &explosionTexture,
                   AsteroidFactory &asteroidFactory)
@@ -28,360 +82,315 @@ public:
         explosionTexture(explosionTexture),
         asteroidFactory(asteroidFactory)
   {
-    registerCollisionHandlers();
+    // a handler for each pair the matrix lets through and nothing else
+    for (std::size_t a = 0; a < COLLISION_TYPES; ++a) {
+      for (std::size_t b = a; b < COLLISION_TYPES; ++b) {
+        assert((collisionHandler(CollisionType(a), CollisionType(b)) != nullptr) ==
+                   collides(CollisionType(a), CollisionType(b)) &&
+               "the collision handlers don't match the collision matrix");
+      }
+    }
   }
 
   void Update() {
+    candidatePairs = 0;
+
+    // the handlers queue their destroys and new debris on the command buffer,
+    // nothing is added or removed until the next ecs.flush(). So the group and
+    // the component references stay put while we iterate, entities that have
+    // been destroyed are just no longer valid.
+    auto &colliders = ecs.group<Collision>();
+
+    // broadphase: only entities sharing a grid cell can collide
+    buildBroadphase(colliders);
 
-    for (auto e : ecs.view<Collision>()) {
+    // detection: the cells spread over the thread pool, nothing is changed
+    // until all the contacts are in
+    detectContacts(colliders);
 
-      // it is possible that the entity has been destroyed by the callback in the meantime
-      if (!ecs.isAlive(e))
+    // resolution, on this thread in contact order, i.e. in group order of the
+    // first entity then the second. A handler can destroy an entity that has
+    // more contacts to come.
+    for (auto [first, second] : contacts) {
+      Entity e = colliders[first];
+      Entity other = colliders[second];
+
+      if (!ecs.valid(e) || !ecs.valid(other))
         continue;
 
-      auto &collision = ecs.getComponent<Collision>(e);
-      auto &pos = ecs.getComponent<Position>(e);
-      auto &rot = ecs.getComponent<Rotation>(e);
-
-      // check for collisions with other entities
-      for (auto other : ecs.view<Collision>()) {
-        if (e == other)
-          continue; // skip self collision
-
-        // it is possible that the entity has been destroyed by the callback in the meantime
-        if (!ecs.isAlive(e))
-          continue;
-
-        auto& otherCollision = ecs.getComponent<Collision>(other);
-        auto& otherPos = ecs.getComponent<Position>(other);
-        auto& otherRot = ecs.getComponent<Rotation>(other);
-
-        // Perform collision detection based on shape type
-        if (collision.type      == ShapeType::AABB &&
-            otherCollision.type == ShapeType::AABB) {
-          if (AABBCollision(pos.value, rot.angle, collision.halfWidth, collision.halfHeight, 
-                            otherPos.value, otherRot.angle, otherCollision.halfWidth, otherCollision.halfHeight)) {
-            handleCollision(e, other);
-          }
-        } else if (collision.type      == ShapeType::Circle &&
-                   otherCollision.type == ShapeType::Circle) {
-          if (CircleCollision(pos.value, collision.radius, 
-                              otherPos.value, otherCollision.radius)) {
-            handleCollision(e, other);
-          }
-        }
-      }
+      handleCollision(e, other);
     }
   };
 
+  // candidate pairs the broadphase handed out in the last Update(), for
+  // profiling (every entity against every other would be n * (n - 1) / 2)
+  std::size_t candidatePairs = 0;
+
+  // the box round a collider that the narrowphase can't hit outside of, the
+  // world-aligned box round the turned box
+  static sf::Vector2f broadphaseExtent(const Collision &collision, const Orientation &orientation) {
+    if (collision.type == ShapeType::Circle) {
+      return {collision.radius, collision.radius};
+    }
+    return {collision.halfWidth * std::abs(orientation.forward.x) + collision.halfHeight * std::abs(orientation.right.x),
+            collision.halfWidth * std::abs(orientation.forward.y) + collision.halfHeight * std::abs(orientation.right.y)};
+  }
+
+  ///////////////////////////////////////////////////////////////////////////////
+  // Narrowphase
+  ///////////////////////////////////////////////////////////////////////////////
+  // Boxes are turned with their entity, halfWidth along its forward vector
+  // and halfHeight along its right. The trig comes cached in the
+  // Orientations, so none of these do any.
+
+  static bool shapesOverlap(const Collision &collision1, sf::Vector2f pos1, const Orientation &orientation1,
+                            const Collision &collision2, sf::Vector2f pos2, const Orientation &orientation2) {
+    if (collision1.type == ShapeType::AABB && collision2.type == ShapeType::AABB) {
+      return OBBCollision(pos1, orientation1, collision1.halfWidth, collision1.halfHeight,
+                          pos2, orientation2, collision2.halfWidth, collision2.halfHeight);
+    }
+    if (collision1.type == ShapeType::Circle && collision2.type == ShapeType::Circle) {
+      return CircleCollision(pos1, collision1.radius, pos2, collision2.radius);
+    }
+    if (collision1.type == ShapeType::Circle) {
+      return CircleOBBCollision(pos1, collision1.radius, pos2, orientation2, collision2.halfWidth, collision2.halfHeight);
+    }
+    return CircleOBBCollision(pos2, collision2.radius, pos1, orientation1, collision1.halfWidth, collision1.halfHeight);
+  }
+
+  // separating axis test: two boxes overlap unless the gap between their
+  // centres along one of their four edge directions is more than they reach
+  static bool OBBCollision(sf::Vector2f pos1, const Orientation &orientation1, float halfWidth1, float halfHeight1,
+                           sf::Vector2f pos2, const Orientation &orientation2, float halfWidth2, float halfHeight2) {
+    sf::Vector2f d = pos2 - pos1;
+
+    auto separates = [&](sf::Vector2f axis) {
+      float reach1 = halfWidth1 * std::abs(orientation1.forward.dot(axis)) +
+                     halfHeight1 * std::abs(orientation1.right.dot(axis));
+      float reach2 = halfWidth2 * std::abs(orientation2.forward.dot(axis)) +
+                     halfHeight2 * std::abs(orientation2.right.dot(axis));
+      return std::abs(d.dot(axis)) >= reach1 + reach2;
+    };
+
+    return !separates(orientation1.forward) && !separates(orientation1.right) &&
+           !separates(orientation2.forward) && !separates(orientation2.right);
+  }
+
+  static bool CircleCollision(sf::Vector2f pos1, float radius1, sf::Vector2f pos2, float radius2) {
+    float dx = pos1.x - pos2.x;
+    float dy = pos1.y - pos2.y;
+    float distanceSquared = dx * dx + dy * dy;
+    float radiusSum = radius1 + radius2;
+    return distanceSquared < (radiusSum * radiusSum);
+  }
+
+  // the circle's centre in the box's frame against the nearest point of the
+  // box to it
+  static bool CircleOBBCollision(sf::Vector2f circlePos, float radius, sf::Vector2f boxPos,
+                                 const Orientation &orientation, float halfWidth, float halfHeight) {
+    sf::Vector2f d = circlePos - boxPos;
+    float x = d.dot(orientation.forward);
+    float y = d.dot(orientation.right);
+    float dx = x - std::clamp(x, -halfWidth, halfWidth);
+    float dy = y - std::clamp(y, -halfHeight, halfHeight);
+    return (dx * dx + dy * dy) < (radius * radius);
+  }
 
 private:
   Coordinator &ecs;
-  sf::Sound &pdcHitSoundPlayer;
-  sf::Sound &explosionSoundPlayer;
+  SoundEffect &pdcHitSoundPlayer;
+  SoundEffect &explosionSoundPlayer;
   std::vector<Explosion> &explosions; // to store explosions
   sf::Texture &explosionTexture;      // texture for explosions
   AsteroidFactory &asteroidFactory;
 
-  inline static std::map<std::pair<CollisionType, CollisionType>, CollisionHandler> collisionHandlers;
-
-  void registerCollisionHandlers() {
-
-    // SHIP & ASTEROID
-    collisionHandlers[{CollisionType::SHIP, CollisionType::ASTEROID}] = 
-      [this](Entity e1, Entity e2) {
-        // damage will depend on the speed of both. 
-        // std::cout << "Ship vs Asteroid collision detected between " << e1 << " and " << e2 << "\n";
-        auto &vel1 = ecs.getComponent<Velocity>(e1);
-        auto &vel2 = ecs.getComponent<Velocity>(e2);
-        auto damage = vel1.value + vel2.value;
-        auto &ehealth = ecs.getComponent<Health>(e1);
-
-        // reduce health based on 
-        ehealth.value -= static_cast<uint32_t>(damage.length() / 10.f);
-
-        // std::cout << "Ship health reduced by: " << (damage.length() / 10.f) << "\n";
-
-        // bounce the ship off the asteroid
-        vel1.value = -vel1.value * 0.5f;
-      };
-
-    collisionHandlers[{CollisionType::ASTEROID, CollisionType::SHIP}] = 
-      [this](Entity e1, Entity e2) {
-        // std::cout << "Ship vs Asteroid collision detected between " << e1 << " and " << e2 << "\n";
-        auto &vel1 = ecs.getComponent<Velocity>(e1);
-        auto &vel2 = ecs.getComponent<Velocity>(e2);
-        auto damage = vel1.value + vel2.value;
-        auto &ehealth = ecs.getComponent<Health>(e2);
-
-        // reduce health based on 
-        ehealth.value -= static_cast<uint32_t>(damage.length() / 10.f);
-
-        // std::cout << "Ship health reduced by: " << (damage.length() / 10.f) << "\n";
-
-        // bounce the ship off the asteroid
-        vel2.value = -vel2.value * 0.5f;
-      };
- 
-    // SHIP & PROJECTILE
-    collisionHandlers[{CollisionType::SHIP, CollisionType::PROJECTILE}] = 
-      [this](Entity e1, Entity e2) {
-        auto &damage = ecs.getComponent<Collision>(e2).damage;
-
-        // grab any pdc for now
-        auto &mounts = ecs.getComponent<PdcMounts>(e1);
-        auto &ehealth = ecs.getComponent<Health>(e1);
-        ehealth.value -= damage; 
-        pdcHitSoundPlayer.play();
-        destroyEntity(ecs, e2);
-      };
-
-    collisionHandlers[{CollisionType::PROJECTILE, CollisionType::SHIP}] = 
-      [this](Entity e1, Entity e2) {
-        auto &damage = ecs.getComponent<Collision>(e1).damage;
-
-        // grab any pdc for now
-        auto &mounts = ecs.getComponent<PdcMounts>(e2);
-        auto &ehealth = ecs.getComponent<Health>(e2);
-        ehealth.value -= damage;
-        pdcHitSoundPlayer.play();
-        destroyEntity(ecs, e1);
-      };
-
-    // SHIP & TORPEDO
-    collisionHandlers[{CollisionType::SHIP, CollisionType::TORPEDO}] = 
-      [this](Entity e1, Entity e2) {
-        auto &damage = ecs.getComponent<Collision>(e2).damage;
-        auto &ehealth = ecs.getComponent<Health>(e1);
-        ehealth.value -= damage; 
-
-        // trigger explosion
-        auto &e2pos = ecs.getComponent<Position>(e2);
-        explosions.emplace_back(&explosionTexture, e2pos.value, 8, 7);
-        explosionSoundPlayer.play();
-        destroyEntity(ecs, e2);
-      };
-
-    collisionHandlers[{CollisionType::TORPEDO, CollisionType::SHIP}] = 
-      [this](Entity e1, Entity e2) {
-        auto &damage = ecs.getComponent<Collision>(e1).damage;
-        auto &ehealth = ecs.getComponent<Health>(e2);
-        ehealth.value -= damage;
-
-        // trigger explosion
-        auto &e1pos = ecs.getComponent<Position>(e1);
-        explosions.emplace_back(&explosionTexture, e1pos.value, 8, 7);
-        explosionSoundPlayer.play();
-        destroyEntity(ecs, e1);
-      };
-
-    // PROJECTILE & TORPEDO
-    collisionHandlers[{CollisionType::PROJECTILE, CollisionType::TORPEDO}] = 
-      [this](Entity e1, Entity e2) {
-        // trigger explosion
-        auto &e2pos = ecs.getComponent<Position>(e2);
-        explosions.emplace_back(&explosionTexture, e2pos.value, 8, 7);
-        explosionSoundPlayer.play();
-        destroyEntity(ecs, e1);
-        destroyEntity(ecs, e2);
-      };
-
-    collisionHandlers[{CollisionType::TORPEDO, CollisionType::PROJECTILE}] = 
-      [this](Entity e1, Entity e2) {
-        // trigger explosion
-        auto &e1pos = ecs.getComponent<Position>(e1);
-        explosions.emplace_back(&explosionTexture, e1pos.value, 8, 7);
-        explosionSoundPlayer.play();
-        destroyEntity(ecs, e1);
-        destroyEntity(ecs, e2);
-      };
-
-    // ASTEROID & PROJECTILE
-    collisionHandlers[{CollisionType::ASTEROID, CollisionType::PROJECTILE}] =
-      [this](Entity e1, Entity e2) {
-        // std::cout << "Asteroid vs Projectile collision detected between " << e1 << " and " << e2 << "\n";
-        destroyEntity(ecs, e2);
-      };
-
-    collisionHandlers[{CollisionType::PROJECTILE, CollisionType::ASTEROID}] =
-      [this](Entity e1, Entity e2) {
-        // std::cout << "Asteroid vs Projectile collision detected between " << e1 << " and " << e2 << "\n";
-        destroyEntity(ecs, e1);
-      };
-
-    // ASTEROID & TORPEDO
-    collisionHandlers[{CollisionType::ASTEROID, CollisionType::TORPEDO}] =
-      [this](Entity e1, Entity e2) {
-        std::cout << "Asteroid vs Torpedo collision detected between " << e1 << " and " << e2 << "\n";
-        // trigger explosion
-        auto &e1pos = ecs.getComponent<Position>(e1);
-        auto &e2pos = ecs.getComponent<Position>(e2);
-        explosions.emplace_back(&explosionTexture, e2pos.value, 8, 7);
-        explosionSoundPlayer.play();
-        destroyEntity(ecs, e2);
-
-        // destroy the asteroid if it is large enough and create smaller asteroids
-        // with alot of spin and velocity
-        destroyEntity(ecs, e1);
-        asteroidFactory.createDebrisAsteroids(e1pos.value);
-      };
-
-    collisionHandlers[{CollisionType::TORPEDO, CollisionType::ASTEROID}] =
-      [this](Entity e1, Entity e2) {
-        std::cout << "Asteroid vs Torpedo collision detected between " << e1 << " and " << e2 << "\n";
-        // trigger explosion
-        auto &e1pos = ecs.getComponent<Position>(e1);
-        auto &e2pos = ecs.getComponent<Position>(e2);
-        explosions.emplace_back(&explosionTexture, e1pos.value, 8, 7);
-        explosionSoundPlayer.play();
-        destroyEntity(ecs, e1);
-
-        // destroy the asteroid if it is large enough and create smaller asteroids
-        // with alot of spin and velocity
-        destroyEntity(ecs, e2);
-        asteroidFactory.createDebrisAsteroids(e2pos.value);
-      };
-
-    collisionHandlers[{CollisionType::ASTEROID, CollisionType::ASTEROID}] =
-      [this](Entity e1, Entity e2) {
-        auto &vel1 = ecs.getComponent<Velocity>(e1);
-        auto &vel2 = ecs.getComponent<Velocity>(e2);
-
-        vel1.value = -vel1.value * 0.5f; // bounce off each other
-        vel2.value = -vel2.value * 0.5f; // bounce off each other
-      };
-
-    // SHIP & SHIP
-    collisionHandlers[{CollisionType::SHIP, CollisionType::SHIP}] =
-      [this](Entity e1, Entity e2) {
-
-# if 0 // ships will stick if I use this code because of multiple collisions. 
-        auto &vel1 = ecs.getComponent<Velocity>(e1);
-        auto &vel2 = ecs.getComponent<Velocity>(e2);
-
-        vel1.value = -vel1.value * 0.9f; // bounce off each other, try not to stick
-        vel2.value = -vel2.value * 0.9f; // bounce off each other
-#endif
-      };
-
-    // TORPEDO & TORPEDO
-    collisionHandlers[{CollisionType::TORPEDO, CollisionType::TORPEDO}] =
-      [](Entity e1, Entity e2) {
-        // torpedos cant collide with each other, so do nothing.
-      };
-
-    // PROJECTILE & PROJECTILE
-    collisionHandlers[{CollisionType::PROJECTILE, CollisionType::PROJECTILE}] =
-      [](Entity e1, Entity e2) {
-        // bullets cant collide with each other, so do nothing.
-      };
+  SpatialHash broadphase;
+  std::vector<Collision> shapes; // collider i's Collision, for the workers
+
+  // two colliders that touch, as group indices with the lower first
+  using Contact = std::pair<std::uint32_t, std::uint32_t>;
+
+  // what each worker finds, indexed by ThreadPool::currentWorker()
+  struct Detection {
+    std::vector<Contact> contacts; // this tick's so far
+    std::size_t candidatePairs = 0;
+  };
+  std::vector<Detection> detections;
+
+  std::vector<Contact> contacts; // all of this tick's, merged and sorted
+
+  // the grid, and the shapes for the workers while we're at it
+  void buildBroadphase(const std::vector<Entity> &colliders) {
+    broadphase.clear();
+    shapes.clear();
+    for (std::uint32_t i = 0; i < colliders.size(); ++i) {
+      Entity e = colliders[i];
+      auto &collision = ecs.getComponent<Collision>(e);
+      auto &orientation = ecs.getComponent<Orientation>(e);
+      sf::Vector2f pos = ecs.getComponent<Position>(e).value;
+      sf::Vector2f extent = broadphaseExtent(collision, orientation);
+      broadphase.insert(i, pos - extent, pos + extent);
+      shapes.push_back(collision);
+    }
+    broadphase.build();
   }
- 
-  void handleCollision(Entity e1, Entity e2) {
-    // Get the collision types of the entities
-    CollisionType type1 = ecs.getComponent<Collision>(e1).ctype;
-    CollisionType type2 = ecs.getComponent<Collision>(e2).ctype;
 
-    // prevent collision between the firer and the bullet or torpedo fired
-    // this stops fire/launch collisions
-    if (ecs.getComponent<Collision>(e1).firedBy == e2 ||
-        ecs.getComponent<Collision>(e2).firedBy == e1) {
-      // std::cout << "Collision between " << e1Name << " and " << e2Name
-      //           << " prevented due to being fired by the other entity.\n";
-      return;
+  // Every pair sharing a cell that the collision matrix lets through, tested
+  // a few cells per task on the thread pool. The workers only read, and
+  // each keeps its own contacts. The grid hands out each pair from one cell
+  // only, so no contact is found twice, and sorting the merged contacts
+  // puts them in the same order however the cells were split up.
+  void detectContacts(const std::vector<Entity> &colliders) {
+    ThreadPool &threads = ecs.threads();
+    detections.resize(threads.size());
+    for (auto &detection : detections) {
+      detection.contacts.clear();
+      detection.candidatePairs = 0;
     }
 
-    // Check if a handler exists for this pair of collision types
-    auto it = collisionHandlers.find({type1, type2});
-    if (it != collisionHandlers.end()) {
-      it->second(e1, e2);
-    } else {
-      std::cout << "No collision handler for " << static_cast<int>(type1) << " and " << static_cast<int>(type2) << "\n";
+    // a quiet tick has a few dozen cells, not worth waking the workers for
+    std::size_t cells = broadphase.cells();
+    std::size_t grain = std::max<std::size_t>(cells / (threads.size() * 4), 64);
+
+    threads.parallelFor(cells, grain, [&](std::size_t begin, std::size_t end) {
+      Detection &detection = detections[ThreadPool::currentWorker()];
+      std::size_t candidatePairs = 0; // counted here, the Detections share cache lines
+
+      for (std::size_t cell = begin; cell < end; ++cell) {
+        broadphase.eachPairInCell(cell, [&](std::uint32_t first, std::uint32_t second) {
+          ++candidatePairs;
+          const Collision &collision = shapes[first];
+          const Collision &otherCollision = shapes[second];
+
+          // types that don't interact, and the firer and its own bullet or
+          // torpedo (stops fire/launch collisions)
+          if (!collides(collision.ctype, otherCollision.ctype) ||
+              collision.firedBy == colliders[second] || otherCollision.firedBy == colliders[first])
+            return;
+
+          if (shapesOverlap(collision, ecs.getComponent<Position>(colliders[first]).value,
+                            ecs.getComponent<Orientation>(colliders[first]), otherCollision,
+                            ecs.getComponent<Position>(colliders[second]).value,
+                            ecs.getComponent<Orientation>(colliders[second]))) {
+            detection.contacts.push_back({first, second});
+          }
+        });
+      }
+
+      detection.candidatePairs += candidatePairs;
+    });
+
+    contacts.clear();
+    for (auto &detection : detections) {
+      contacts.insert(contacts.end(), detection.contacts.begin(), detection.contacts.end());
+      candidatePairs += detection.candidatePairs;
     }
+    std::sort(contacts.begin(), contacts.end());
+    assert(std::adjacent_find(contacts.begin(), contacts.end()) == contacts.end() && "a contact was found twice");
+  }
+
+  ///////////////////////////////////////////////////////////////////////////////
+  // Collision handlers, one per interacting pair of types in the matrix
+  ///////////////////////////////////////////////////////////////////////////////
+  static CollisionHandler collisionHandler(CollisionType type1, CollisionType type2) {
+    // indexed [lower type][higher type], the lower half is never used
+    static constexpr CollisionHandler handlers[COLLISION_TYPES][COLLISION_TYPES] = {
+        // SHIP
+        {nullptr, &CollisionSystem::shipVsProjectile, &CollisionSystem::shipVsTorpedo,
+         &CollisionSystem::shipVsAsteroid},
+        // PROJECTILE
+        {nullptr, nullptr, &CollisionSystem::projectileVsTorpedo, &CollisionSystem::projectileVsAsteroid},
+        // TORPEDO
+        {nullptr, nullptr, nullptr, &CollisionSystem::torpedoVsAsteroid},
+        // ASTEROID
+        {nullptr, nullptr, nullptr, &CollisionSystem::asteroidVsAsteroid},
+    };
+
+    return handlers[collisionIndex(type1)][collisionIndex(type2)];
   }
 
+  void handleCollision(Entity e1, Entity e2) {
+    CollisionType type1 = ecs.getComponent<Collision>(e1).ctype;
+    CollisionType type2 = ecs.getComponent<Collision>(e2).ctype;
 
-  // check for AABB collision
-  // use a dynamic AABB rectangle, whish isnt the best solution as the rectangle gets bigger 
-  // in certain situations, but will do for now. 
-  bool AABBCollision (sf::Vector2f pos1, float rot1, float halfWidth1, float halfHeight1, 
-                      sf::Vector2f pos2, float rot2, float halfWidth2, float halfHeight2) {
+    // handlers take their pair in type order
+    if (type2 < type1) {
+      std::swap(e1, e2);
+      std::swap(type1, type2);
+    }
 
-    // take into account the rotation of the object, if it is big enough to make a difference
-    float hw1new = 0.f;
-    float hh1new = 0.f;
-    float hw2new = 0.f;
-    float hh2new = 0.f;
+    CollisionHandler handler = collisionHandler(type1, type2);
+    assert(handler && "No collision handler for a pair in the collision matrix");
+    (this->*handler)(e1, e2);
+  }
 
-    // compute absolute cos/sin
-    if (halfWidth1 > 100.f || halfHeight1 > 100.f) {
-      float ca1 = std::abs(std::cos(rot1 * (M_PI / 180.f)));
-      float sa1 = std::abs(std::sin(rot1 * (M_PI / 180.f)));
+  void shipVsProjectile(Entity ship, Entity round) {
+    auto &damage = ecs.getComponent<Collision>(round).damage;
 
-      hw1new = halfWidth1 * ca1 + halfHeight1 * sa1;
-      hh1new = halfWidth1 * sa1 + halfHeight1 * ca1;
+    ecs.patch<Health>(ship, [&](Health &health) { health.value -= damage; });
+    pdcHitSoundPlayer.play();
+    destroyEntity(ecs, round);
+  }
 
-      halfWidth1 = hw1new;
-      halfHeight1 = hh1new;
-    }
+  void shipVsTorpedo(Entity ship, Entity torpedo) {
+    auto &damage = ecs.getComponent<Collision>(torpedo).damage;
+    ecs.patch<Health>(ship, [&](Health &health) { health.value -= damage; });
 
-    if (halfWidth2 > 100.f || halfHeight2 > 100.f) {
-      float ca2 = std::abs(std::cos(rot2 * (M_PI / 180.f)));
-      float sa2 = std::abs(std::sin(rot2 * (M_PI / 180.f)));
+    // trigger explosion
+    auto &torpedoPos = ecs.getComponent<Position>(torpedo);
+    explosions.emplace_back(&explosionTexture, torpedoPos.value, 8, 7);
+    explosionSoundPlayer.play();
+    destroyEntity(ecs, torpedo);
+  }
 
-      hw2new = halfWidth2 * ca2 + halfHeight2 * sa2;
-      hh2new = halfWidth2 * sa2 + halfHeight2 * ca2;
+  void shipVsAsteroid(Entity ship, Entity asteroid) {
+    // damage will depend on the speed of both. 
+    auto &shipVel = ecs.getComponent<Velocity>(ship);
+    auto &asteroidVel = ecs.getComponent<Velocity>(asteroid);
+    auto damage = shipVel.value + asteroidVel.value;
+    // reduce health based on 
+    ecs.patch<Health>(ship, [&](Health &health) { health.value -= static_cast<uint32_t>(damage.length() / 10.f); });
 
-      halfWidth2 = hw2new;
-      halfHeight2 = hh2new;
-    }
+    // std::cout << "Ship health reduced by: " << (damage.length() / 10.f) << "\n";
 
-    bool collision = (pos1.x - halfWidth1 < pos2.x + halfWidth2 &&
-            pos1.x + halfWidth1 > pos2.x - halfWidth2 &&
-            pos1.y - halfHeight1 < pos2.y + halfHeight2 &&
-            pos1.y + halfHeight1 > pos2.y - halfHeight2);
-#if 0
-    if (collision) {
+    // bounce the ship off the asteroid
+    shipVel.value = -shipVel.value * 0.5f;
+  }
 
-      std::cout << 
-        "AABB Collision detected " << "\n" << "pos1.x " << pos1.x << " pos1.y " << pos1.y << 
-        " halfWidth1 " << halfWidth1 << " halfHeight1 " << halfHeight1 << "\n" <<
-        "pos2.x " << pos2.x << " pos2.y " << pos2.y << 
-        " halfWidth2 " << halfWidth2 << " halfHeight2 " << halfHeight2 << std::endl;
+  void projectileVsTorpedo(Entity round, Entity torpedo) {
+    // trigger explosion
+    auto &torpedoPos = ecs.getComponent<Position>(torpedo);
+    explosions.emplace_back(&explosionTexture, torpedoPos.value, 8, 7);
+    explosionSoundPlayer.play();
+    destroyEntity(ecs, round);
+    destroyEntity(ecs, torpedo);
+  }
 
-    }
-#endif
-    return collision;
+  void projectileVsAsteroid(Entity round, Entity /*asteroid*/) {
+    // std::cout << "Asteroid vs Projectile collision detected between " << asteroid << " and " << round << "\n";
+    destroyEntity(ecs, round);
   }
 
-  bool CircleCollision (sf::Vector2f pos1, float radius1, 
-                        sf::Vector2f pos2, float radius2) {
-    float dx = pos1.x - pos2.x;
-    float dy = pos1.y - pos2.y;
-    float distanceSquared = dx * dx + dy * dy;
-    float radiusSum = radius1 + radius2;
-    return distanceSquared < (radiusSum * radiusSum);
+  void torpedoVsAsteroid(Entity torpedo, Entity asteroid) {
+    // std::cout << "Asteroid vs Torpedo collision detected between " << asteroid << " and " << torpedo << "\n";
+    // trigger explosion
+    auto &torpedoPos = ecs.getComponent<Position>(torpedo);
+    auto &asteroidPos = ecs.getComponent<Position>(asteroid);
+    explosions.emplace_back(&explosionTexture, torpedoPos.value, 8, 7);
+    explosionSoundPlayer.play();
+    destroyEntity(ecs, torpedo);
+
+    // destroy the asteroid if it is large enough and create smaller asteroids
+    // with alot of spin and velocity
+    destroyEntity(ecs, asteroid);
+    asteroidFactory.createDebrisAsteroids(asteroidPos.value);
   }
 
-  #if 0
-    bool CirclevsCircle(const TransformComponent& t1, const CollisionComponent& c1,
-                        const TransformComponent& t2, const CollisionComponent& c2) const {
-        float dx = t1.position.x - t2.position.x;
-        float dy = t1.position.y - t2.position.y;
-        float distSq = dx * dx + dy * dy;
-        float radiusSum = c1.radius + c2.radius;
-        return distSq <= (radiusSum * radiusSum);
-    }
+  void asteroidVsAsteroid(Entity e1, Entity e2) {
+    auto &vel1 = ecs.getComponent<Velocity>(e1);
+    auto &vel2 = ecs.getComponent<Velocity>(e2);
 
-    bool AABBvsCircle(const TransformComponent& tA, const CollisionComponent& cA,
-                      const TransformComponent& tC, const CollisionComponent& cC) const {
-        float nearestX = std::max(tA.position.x - cA.halfWidth,
-                                  std::min(tC.position.x, tA.position.x + cA.halfWidth));
-        float nearestY = std::max(tA.position.y - cA.halfHeight,
-                                  std::min(tC.position.y, tA.position.y + cA.halfHeight));
-        float dx = tC.position.x - nearestX;
-        float dy = tC.position.y - nearestY;
-        return (dx * dx + dy * dy) <= (cC.radius * cC.radius);
-    }
-  #endif
+    vel1.value = -vel1.value * 0.5f; // bounce off each other
+    vel2.value = -vel2.value * 0.5f; // bounce off each other
+  }
 };
@@ -2,6 +2,7 @@
 
 #include <SFML/Graphics.hpp>
 #include <SFML/Graphics/Sprite.hpp>
+#include <cmath>
 #include <sys/types.h>
 #include "../include/ecs.hpp"
 
@@ -25,6 +26,31 @@ struct Rotation {
   float angularVelocity = 0.f; // in degrees per second
 };
 
+// Rotation as unit vectors, so the trig is only done when the angle changes.
+// The physics pass brings it up to date every tick, anything that turns an
+// entity later in the tick leaves it stale until currentOrientation().
+struct Orientation {
+  Vec2 forward{1.f, 0.f}; // along the angle
+  Vec2 right{0.f, 1.f};   // forward turned 90 degrees clockwise on screen
+  float angle = 0.f;      // the Rotation angle these are for
+
+  Orientation() = default;
+  explicit Orientation(float angle) { set(angle); }
+
+  void set(float degrees) {
+    // the same sums as rotateVector(), so rotate() gives the same results
+    float radians = degrees * (M_PI / 180.f);
+    float cs = std::cos(radians);
+    float sn = std::sin(radians);
+    forward = {cs, sn};
+    right = {-sn, cs};
+    angle = degrees;
+  }
+
+  // from the entity's frame into the world's, rotateVector(v, angle)
+  Vec2 rotate(Vec2 v) const { return forward * v.x + right * v.y; }
+};
+
 struct SpriteComponent {
   sf::Sprite sprite;
 };
@@ -125,6 +151,7 @@ struct ShipControl {
 
 enum class CollisionType { SHIP, PROJECTILE, TORPEDO, ASTEROID };
 
+// AABB is a box turned with the entity's Rotation, see CollisionSystem
 enum class ShapeType { AABB, Circle};
 
 // Describes the collision shape of an entity
@@ -165,3 +192,10 @@ struct DrivePlume {
   sf::Sprite sprite;
   sf::Vector2f offset{0.f, 0.f}; // position of the drive plume relative to the ship
 };
+
+// every component type the game uses, a component's id is its position here
+using Coordinator = World<Position, Velocity, Acceleration, Rotation, SpriteComponent,
+                          Health, Pdc, TorpedoLauncher1, TorpedoLauncher2, Collision,
+                          TorpedoTarget, TimeFired, PdcMounts, TorpedoControl,
+                          EnemyShipTarget, FriendlyShipTarget, ShipControl, DrivePlume,
+                          Orientation>;
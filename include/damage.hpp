@@ -1,34 +1,37 @@
 #pragma once
+#include "assets.hpp"
 #include "components.hpp"
 #include "ecs.hpp"
 #include "explosion.hpp"
 #include "utils.hpp"
-#include <SFML/Audio/Sound.hpp>
-#include <SFML/Audio/SoundBuffer.hpp>
 #include <SFML/Graphics/Texture.hpp>
+#include <vector>
 
 class DamageSystem {
 public:
 
   DamageSystem(Coordinator &ecs,
-               sf::Sound &explosionSoundPlayer,
+               SoundEffect &explosionSoundPlayer,
                std::vector<Explosion> &explosions,
                sf::Texture &explosionTexture)
   : ecs(ecs),
     explosionSoundPlayer(explosionSoundPlayer),
     explosions(explosions),
-    explosionTexture(explosionTexture)
+    explosionTexture(explosionTexture),
+    damaged(ecs.changed<Health>())
   {}
 
   void Update() {
-    // Iterate through all entities with Health and Position components
-    for (auto entity : ecs.view<Health, Position>()) {
+    // Only the entities whose Health changed since the last update can have
+    // taken enough damage, the rest are left alone
+    for (Entity entity : damaged.entities()) {
       auto &health = ecs.getComponent<Health>(entity);
-      auto &position = ecs.getComponent<Position>(entity);
 
       // Check if health is below or equal to -200 for destruction
       // the enemyAI state machine will disable the ship if < 0
-      if (health.value <= -200) {
+      if (health.value <= -200 && ecs.hasComponent<Position>(entity)) {
+        auto &position = ecs.getComponent<Position>(entity);
+
         // std::cout << "Entity " << entity << " destroyed due to damage.\n";
         // Create an explosion at the entity's position
         explosions.emplace_back(&explosionTexture, position.value, 8, 7);
@@ -37,12 +40,16 @@ public:
         destroyEntity(ecs, entity); 
       }
     }
+
+    damaged.clear();
   }
 
 private:
   Coordinator &ecs;
-  sf::Sound &explosionSoundPlayer;
+  SoundEffect &explosionSoundPlayer;
   std::vector<Explosion> &explosions;
   sf::Texture &explosionTexture;
-};
 
+  // entities whose Health was set or changed since the last Update()
+  ChangeTracker &damaged;
+};
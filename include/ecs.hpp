@@ -1,89 +1,226 @@
 #pragma once
+#include <algorithm>
 #include <array>
+#include <bitset>
 #include <cassert>
 #include <cstdint>
+#include <functional>
 #include <map>
-#include <queue>
+#include <memory>
+#include <new>
 #include <string>
-#include <typeindex>
+#include <tuple>
+#include <type_traits>
 #include <unordered_map>
 #include <utility>
+#include <vector>
 #include <iostream>
 
+#include "threadpool.hpp"
+
+// An Entity is a handle: the low bits are the index of its slot and the high
+// bits are the slot's generation. Destroying an entity bumps the generation,
+// so a handle kept after the entity dies (a torpedo's target, a PDC's target)
+// no longer matches when the slot is reused and valid() returns false.
 using Entity = std::uint32_t;
-constexpr Entity MAX_ENTITIES = 5000;
+
+constexpr std::uint32_t ENTITY_INDEX_BITS = 20;
+constexpr std::uint32_t ENTITY_INDEX_MASK = (1u << ENTITY_INDEX_BITS) - 1;
+constexpr std::uint32_t ENTITY_GENERATION_MASK = 0xFFF; // 12 bits
+
+// every slot index fits in the handle, ~1M live entities
+constexpr std::uint32_t MAX_ENTITIES = 1u << ENTITY_INDEX_BITS;
+
+// never returned by createEntity, used for "no target"
+constexpr Entity NULL_ENTITY = 0xFFFFFFFF;
+
+// Entity names (Bullet, Torpedo, PDC5, Rocinante...) are interned, each
+// distinct string gets a small id that is cheap to store and compare
+using NameId = std::uint32_t;
+constexpr NameId NO_NAME = 0xFFFFFFFF;
+
+constexpr std::uint32_t entityIndex(Entity e) { return e & ENTITY_INDEX_MASK; }
+constexpr std::uint32_t entityGeneration(Entity e) { return e >> ENTITY_INDEX_BITS; }
+
+constexpr Entity makeEntity(std::uint32_t index, std::uint32_t generation) {
+  return (generation << ENTITY_INDEX_BITS) | index;
+}
 
 ///////////////////////////////////////////////////////////////////////////////
 // ENTITY MANAGER
 ///////////////////////////////////////////////////////////////////////////////
+// Slots are allocated a page at a time as entities are created, so nothing is
+// reserved up front and existing slots never move. Free slots are chained
+// through the slots themselves, first in first out, so a freed slot waits as
+// long as possible before it is reused and its generation wraps slowly.
 class EntityManager {
-  std::queue<Entity> freeEntities;
-  std::array<bool, MAX_ENTITIES> alive{};
-  std::map<Entity, std::string> name{}; // e.g. Rocinante, enemy, bullet
+  static constexpr std::uint32_t PAGE_BITS = 12;
+  static constexpr std::uint32_t PAGE_SIZE = 1u << PAGE_BITS; // slots per page
+  static constexpr std::uint32_t NO_SLOT = 0xFFFFFFFF;
+
+  struct Slot {
+    std::uint32_t nextFree = NO_SLOT; // next slot in the free list
+    NameId name = NO_NAME;
+    std::uint32_t nameIndex = 0;      // position in named[name]
+    std::uint16_t generation = 0;     // current generation of the slot
+    bool alive = false;
+    bool pendingDestroy = false;      // queued on a command buffer, see valid()
+  };
 
-  // use unordered_map for faster access for all entities with a given name
-  // could have std::vector<Entity> instead of int, keep simple for now
-  std::unordered_multimap<std::string, int> nameToIds{};
+  using Page = std::array<Slot, PAGE_SIZE>;
+
+  std::vector<std::unique_ptr<Page>> pages;
+  std::uint32_t slotCount = 0;        // slots handed out so far, free or alive
+  std::uint32_t freeHead = NO_SLOT;   // oldest free slot, reused first
+  std::uint32_t freeTail = NO_SLOT;   // most recently freed slot
+
+  std::uint32_t liveCount = 0;
+  std::uint32_t peakCount = 0;
+
+  // interned names, e.g. Rocinante, enemy, bullet
+  std::unordered_map<std::string, NameId> nameIds;
+  std::vector<std::string> names;        // NameId -> string
+
+  // all live entities with a given name, unordered so removal is swap and pop
+  std::vector<std::vector<Entity>> named; // NameId -> entities
+
+  Slot &slot(std::uint32_t index) {
+    return (*pages[index >> PAGE_BITS])[index & (PAGE_SIZE - 1)];
+  }
+
+  const Slot &slot(std::uint32_t index) const {
+    return (*pages[index >> PAGE_BITS])[index & (PAGE_SIZE - 1)];
+  }
 
 public:
-  EntityManager() {
-    for (Entity e = 0; e < MAX_ENTITIES; ++e) {
-      freeEntities.push(e);
+  // the id for a name, added the first time it is seen
+  NameId intern(const std::string &ename) {
+    auto it = nameIds.find(ename);
+    if (it != nameIds.end()) {
+      return it->second;
     }
-  }
 
-  Entity create(std::string ename = "") {
-    assert(!freeEntities.empty() && "Too many entities created");
-    Entity id = freeEntities.front();
-    freeEntities.pop();
-    alive[id] = true;
-    name.insert({id, ename});
-    nameToIds.insert({ename, id});
+    NameId id = static_cast<NameId>(names.size());
+    nameIds.emplace(ename, id);
+    names.push_back(ename);
+    named.emplace_back();
     return id;
   }
 
-  void destroy(Entity e) {
-    assert(alive[e] && "Destroying non existant entity");
-    alive[e] = false;
-    freeEntities.push(e);
-
-    // erase the entity with name i.e a single bullet from the unordered_multimap
-    const std::string ename = name.at(e);
-    auto range = nameToIds.equal_range(ename);
-    for (auto it = range.first; it != range.second;) {
-      if (it->second == e) {
-        // erase returns the next iterator; safe during iteration
-        // shouldnt need this as we break, but just in case. 
-        it = nameToIds.erase(it);
-        break;
+  Entity create(const std::string &ename = "") { return create(intern(ename)); }
+
+  Entity create(NameId nameId) {
+    assert(nameId < names.size() && "Unknown entity name");
+
+    std::uint32_t index = freeHead;
+
+    if (index != NO_SLOT) {
+      // reuse the oldest free slot
+      freeHead = slot(index).nextFree;
+      if (freeHead == NO_SLOT) {
+        freeTail = NO_SLOT;
       }
-      else {
-        ++it;
+    }
+    else {
+      // no free slots, take a new one and add a page if this one is full
+      assert(slotCount < MAX_ENTITIES && "Too many entities created");
+      index = slotCount++;
+      if (index >> PAGE_BITS == pages.size()) {
+        pages.push_back(std::make_unique<Page>());
       }
     }
 
-    name.erase(e);
+    Slot &s = slot(index);
+    s.alive = true;
+    s.pendingDestroy = false;
+    s.nextFree = NO_SLOT;
+
+    ++liveCount;
+    if (liveCount > peakCount) {
+      peakCount = liveCount;
+    }
+
+    Entity id = makeEntity(index, s.generation);
+    s.name = nameId;
+    s.nameIndex = static_cast<std::uint32_t>(named[nameId].size());
+    named[nameId].push_back(id);
+    return id;
+  }
+
+  void destroy(Entity e) {
+    assert(exists(e) && "Destroying non existant entity");
+    std::uint32_t index = entityIndex(e);
+    Slot &s = slot(index);
+    s.alive = false;
+
+    // the top generation is skipped so the last slot can never make NULL_ENTITY
+    s.generation = (s.generation + 1) % ENTITY_GENERATION_MASK;
+
+    // append to the end of the free list
+    if (freeTail == NO_SLOT) {
+      freeHead = index;
+    }
+    else {
+      slot(freeTail).nextFree = index;
+    }
+    freeTail = index;
+
+    --liveCount;
+
+    // swap and pop e out of the list of entities with its name
+    std::vector<Entity> &list = named[s.name];
+    Entity last = list.back();
+    list[s.nameIndex] = last;
+    slot(entityIndex(last)).nameIndex = s.nameIndex;
+    list.pop_back();
+    s.name = NO_NAME;
   }
 
-  bool isAlive(Entity e) {
-    assert(e < MAX_ENTITIES && "Entity out of range");
-    return alive[e];
+  // true if e is a live entity, false for NULL_ENTITY, stale handles and
+  // entities that are queued to be destroyed
+  bool valid(Entity e) const {
+    return exists(e) && !slot(entityIndex(e)).pendingDestroy;
   }
 
-  std::string getName(Entity e) {
-    assert(e < MAX_ENTITIES && "Entity out of range");
-    return name.at(e);
+  // true if e hasn't been destroyed yet, even if it is queued to be
+  bool exists(Entity e) const {
+    std::uint32_t index = entityIndex(e);
+    if (index >= slotCount)
+      return false;
+
+    const Slot &s = slot(index);
+    return s.alive && s.generation == entityGeneration(e);
   }
 
-  // e.g. get all Missiles
-  std::vector<Entity> getEntitiesByName(std::string ename) {
-    std::vector<Entity> result;
-    auto range = nameToIds.equal_range(ename);
+  void markPendingDestroy(Entity e) {
+    assert(exists(e) && "Destroying non existant entity");
+    slot(entityIndex(e)).pendingDestroy = true;
+  }
 
-    for (auto it = range.first; it != range.second; ++it) {
-      result.push_back(it->second);
-    }
-    return result;
+  // occupancy
+  std::uint32_t size() const { return liveCount; }      // live entities now
+  std::uint32_t peak() const { return peakCount; }      // most live entities at once
+  std::uint32_t capacity() const {                      // slots allocated
+    return static_cast<std::uint32_t>(pages.size()) * PAGE_SIZE;
+  }
+
+  NameId getNameId(Entity e) const {
+    assert(exists(e) && "Entity out of range");
+    return slot(entityIndex(e)).name;
+  }
+
+  const std::string &getName(Entity e) const { return names[getNameId(e)]; }
+
+  // the id for a name, or NO_NAME if no entity has ever had it
+  NameId findName(const std::string &ename) const {
+    auto it = nameIds.find(ename);
+    return it != nameIds.end() ? it->second : NO_NAME;
+  }
+
+  // e.g. get all Missiles
+  const std::vector<Entity> &getEntitiesByName(NameId nameId) const {
+    static const std::vector<Entity> none;
+    return nameId < named.size() ? named[nameId] : none;
   }
 };
 
@@ -91,142 +228,1418 @@ public:
 // COMPONENT MANAGER
 ///////////////////////////////////////////////////////////////////////////////
 
-// I for interface, polymorphic destructor: correct derived-class destructor
-// will be called
-class IComponentArray {
-public:
-  virtual ~IComponentArray() = default;
+// Component types are fixed at compile time by the World's template argument
+// list, and a component's id is its index in that list. Looking up the storage
+// for a component is then a std::get or an array index, no hashing.
+template <typename T, typename... Ts> struct TypeIndex;
+
+template <typename T, typename... Ts>
+struct TypeIndex<T, T, Ts...> : std::integral_constant<std::size_t, 0> {};
+
+template <typename T, typename U, typename... Ts>
+struct TypeIndex<T, U, Ts...>
+    : std::integral_constant<std::size_t, 1 + TypeIndex<T, Ts...>::value> {};
+
+template <typename T, typename... Ts>
+constexpr bool IsOneOf = (std::is_same_v<T, Ts> || ...);
+
+// The set of components an entity has, one bit per component id. Testing
+// whether an entity belongs in a view or group is then a mask AND.
+using ComponentType = std::uint8_t;
+constexpr ComponentType MAX_COMPONENTS = 32;
+using Signature = std::bitset<MAX_COMPONENTS>;
+
+// Terms for World::each() and World::range(). A plain component is required
+// and handed over by reference. Optional<T> is handed over as a pointer,
+// nullptr if the entity doesn't have a T. Exclude<T> skips entities that have
+// a T and isn't handed over at all.
+template <typename T> struct Optional {};
+template <typename T> struct Exclude {};
+
+template <typename Q> struct QueryTerm {
+  using Component = Q;
+  static constexpr bool required = true;
+  static constexpr bool excluded = false;
+};
+
+template <typename T> struct QueryTerm<Optional<T>> {
+  using Component = T;
+  static constexpr bool required = false;
+  static constexpr bool excluded = false;
 };
 
-template <typename T> class ComponentArray : public IComponentArray {
-  std::unordered_map<Entity, T> data;
+template <typename T> struct QueryTerm<Exclude<T>> {
+  using Component = T;
+  static constexpr bool required = false;
+  static constexpr bool excluded = true;
+};
+
+// Sparse set storage. The components are packed into a dense array with a
+// parallel dense array of their owning entities, and a sparse array indexed by
+// entity slot points into the dense arrays. get/has are a couple of array
+// lookups and iterating the dense arrays is contiguous. has() also checks the
+// owner's generation, so a stale handle never sees the slot's new entity.
+template <typename T> class ComponentArray {
+  static constexpr std::uint32_t NO_INDEX = 0xFFFFFFFF;
+
+  std::vector<T> dense;             // packed components
+  std::vector<Entity> denseEntity;  // owner of each packed component
+  std::vector<std::uint32_t> sparse; // entity slot -> index into dense, or NO_INDEX
 
 public:
-  // insert_or_assign will either insert a new element by moving in the
-  // component, or overwrite an existing one. This prevents the need for a
-  // default constructor in SpriteComponent.
+  // overwrite an existing component, otherwise append it to the end of the
+  // dense arrays. Moving the component in prevents the need for a default
+  // constructor in SpriteComponent.
   void insert(Entity e, T component) {
-    data.insert_or_assign(e, std::move(component));
+    std::uint32_t slot = entityIndex(e);
+    if (has(e)) {
+      dense[sparse[slot]] = std::move(component);
+      return;
+    }
+
+    if (slot >= sparse.size()) {
+      sparse.resize(slot + 1, NO_INDEX);
+    }
+
+    assert(sparse[slot] == NO_INDEX && "Component left behind by a destroyed entity");
+    sparse[slot] = static_cast<std::uint32_t>(dense.size());
+    dense.push_back(std::move(component));
+    denseEntity.push_back(e);
   }
-  void remove(Entity e) { data.erase(e); }
-  T &get(Entity e) { return data.at(e); }
-  bool has(Entity e) { return data.find(e) != data.end(); }
 
-  std::vector<Entity> getEntities() const {
-    std::vector<Entity> v;
-    v.reserve(data.size());
-    for (auto const &kv : data) {
-      v.push_back(kv.first);
+  // room for count more components without the dense arrays reallocating
+  void reserve(std::size_t count) {
+    dense.reserve(dense.size() + count);
+    denseEntity.reserve(denseEntity.size() + count);
+  }
+
+  // swap and pop: move the last component into the hole so the dense arrays
+  // stay packed. Removing a component that isn't there does nothing.
+  void remove(Entity e) {
+    if (!has(e))
+      return;
+
+    std::uint32_t index = sparse[entityIndex(e)];
+    std::uint32_t last = static_cast<std::uint32_t>(dense.size() - 1);
+
+    if (index != last) {
+      dense[index] = std::move(dense[last]);
+      denseEntity[index] = denseEntity[last];
+      sparse[entityIndex(denseEntity[index])] = index;
     }
-    return v;
+
+    dense.pop_back();
+    denseEntity.pop_back();
+    sparse[entityIndex(e)] = NO_INDEX;
   }
+
+  T &get(Entity e) {
+    assert(has(e) && "Entity does not have component");
+    return dense[sparse[entityIndex(e)]];
+  }
+
+  bool has(Entity e) const {
+    std::uint32_t slot = entityIndex(e);
+    return slot < sparse.size() && sparse[slot] != NO_INDEX && denseEntity[sparse[slot]] == e;
+  }
+
+  std::size_t size() const { return dense.size(); }
+
+  // the packed entities, in the same order as the packed components
+  const std::vector<Entity> &entities() const { return denseEntity; }
+
+  std::vector<Entity> getEntities() const { return denseEntity; }
 };
 
-class ComponentManager {
-  std::unordered_map<std::type_index, IComponentArray *> componentArrays;
+// one ComponentArray per component type, held by value in a tuple, plus the
+// signature of every entity so membership tests and teardown don't have to
+// probe each array
+template <typename... Components> class ComponentManager {
+  static_assert(sizeof...(Components) <= MAX_COMPONENTS, "Too many component types");
+
+public:
+  // every array packs its components in its own order, so there are no
+  // runs of rows that line up across components
+  static constexpr bool CHUNKED = false;
+
+private:
+
+  std::tuple<ComponentArray<Components>...> componentArrays;
+  std::vector<Signature> signatures; // entity slot -> components it has
+
+  template <typename T> static void removeOne(ComponentManager &mgr, Entity e) {
+    mgr.getArray<T>().remove(e);
+  }
+
+  template <typename T> static const std::vector<Entity> &entitiesOf(const ComponentManager &mgr) {
+    return std::get<ComponentArray<T>>(mgr.componentArrays).entities();
+  }
+
+  // component id -> removes that component, and -> the entities that have it
+  static constexpr void (*removers[])(ComponentManager &, Entity) = {&removeOne<Components>...};
+  static constexpr const std::vector<Entity> &(*entityLists[])(const ComponentManager &) = {
+      &entitiesOf<Components>...};
 
 public:
-  ~ComponentManager() {
-    for (auto &kv : componentArrays) {
-      delete kv.second;
+  template <typename T> void addComponent(Entity e, T component) {
+    getArray<T>().insert(e, std::move(component));
+
+    std::uint32_t slot = entityIndex(e);
+    if (slot >= signatures.size()) {
+      signatures.resize(slot + 1);
+    }
+    signatures[slot].set(TypeIndex<T, Components...>::value);
+  }
+
+  // grow the arrays of Comps once for count entities about to be spawned
+  template <typename... Comps> void reserve(std::size_t count) { (getArray<Comps>().reserve(count), ...); }
+
+  // give an entity that has no components yet all of its components at once
+  template <typename... Comps> void addComponents(Entity e, Comps &&...components) {
+    (addComponent(e, std::move(components)), ...);
+  }
+
+  template <typename T> void removeComponent(Entity e) {
+    if (!hasComponent<T>(e))
+      return;
+
+    getArray<T>().remove(e);
+    signatures[entityIndex(e)].reset(TypeIndex<T, Components...>::value);
+  }
+
+  template <typename T> T &getComponent(Entity e) {
+    return getArray<T>().get(e);
+  }
+
+  template <typename T> bool hasComponent(Entity e) {
+    return getArray<T>().has(e);
+  }
+
+  // the components a live entity has
+  Signature signature(Entity e) const {
+    std::uint32_t slot = entityIndex(e);
+    return slot < signatures.size() ? signatures[slot] : Signature{};
+  }
+
+  // drop every component of e in one pass over its signature, called when e
+  // is destroyed
+  void removeAll(Entity e) {
+    Signature signature = this->signature(e);
+
+    for (std::size_t id = 0; id < sizeof...(Components); ++id) {
+      if (signature.test(id)) {
+        removers[id](*this, e);
+      }
+    }
+
+    if (signature.any()) {
+      signatures[entityIndex(e)].reset();
+    }
+  }
+
+  template <typename T> ComponentArray<T> &getArray() {
+    static_assert(IsOneOf<T, Components...>, "Component not registered in the World");
+    return std::get<ComponentArray<T>>(componentArrays);
+  }
+
+  // call fn(e) for every entity with all of the required components and none
+  // of the excluded ones. Walks the smallest required array, the rest is a
+  // mask test. required must have at least one bit set.
+  template <typename Fn>
+  void forEachMatching(const Signature &required, const Signature &excluded, Fn &&fn) {
+    const std::vector<Entity> *list = nullptr;
+    for (std::size_t id = 0; id < sizeof...(Components); ++id) {
+      if (required.test(id) && (!list || entityLists[id](*this).size() < list->size())) {
+        list = &entityLists[id](*this);
+      }
     }
+
+    for (Entity e : *list) {
+      const Signature &signature = signatures[entityIndex(e)];
+      if ((signature & required) == required && (signature & excluded).none()) {
+        fn(e);
+      }
+    }
+  }
+
+  // call fn(e, terms...) for every entity matching the query terms Qs
+  template <typename... Qs, typename Fn>
+  void each(const Signature &required, const Signature &excluded, Fn &&fn) {
+    forEachMatching(required, excluded, [&](Entity e) {
+      std::apply(fn, std::tuple_cat(std::tuple<Entity>(e), fetch<Qs>(e)...));
+    });
+  }
+
+  // the argument(s) a query term hands over for e, as a tuple
+  template <typename Q> auto fetch(Entity e) {
+    using Term = QueryTerm<Q>;
+    using T = typename Term::Component;
+
+    if constexpr (Term::excluded) {
+      return std::tuple<>();
+    }
+    else if constexpr (Term::required) {
+      return std::tuple<T &>(getArray<T>().get(e));
+    }
+    else {
+      auto &array = getArray<T>();
+      return std::tuple<T *>(array.has(e) ? &array.get(e) : nullptr);
+    }
+  }
+};
+
+///////////////////////////////////////////////////////////////////////////////
+// ARCHETYPE COMPONENT MANAGER
+///////////////////////////////////////////////////////////////////////////////
+
+// Alternative storage, selected at compile time with ROCI_ECS_ARCHETYPE.
+// Entities with exactly the same set of components (an archetype) are stored
+// together in fixed size chunks, one column per component type (SoA). A view
+// walks the chunks of every matching archetype without probing per entity.
+// Adding or removing a component moves the entity's row to another archetype.
+
+// rows per chunk, columns reserve this up front so they never reallocate
+constexpr std::size_t CHUNK_CAPACITY = 256;
+
+// column storage starts on a 32 byte boundary so SIMD loops over a chunk
+// (see eachChunk()) can use aligned AVX2/SSE loads
+constexpr std::size_t COLUMN_ALIGNMENT = 32;
+
+template <typename T> struct ColumnAllocator {
+  using value_type = T;
+
+  ColumnAllocator() = default;
+  template <typename U> ColumnAllocator(const ColumnAllocator<U> &) {}
+
+  T *allocate(std::size_t n) {
+    return static_cast<T *>(::operator new(n * sizeof(T), std::align_val_t(alignof(T) > COLUMN_ALIGNMENT ? alignof(T) : COLUMN_ALIGNMENT)));
+  }
+
+  void deallocate(T *p, std::size_t) {
+    ::operator delete(p, std::align_val_t(alignof(T) > COLUMN_ALIGNMENT ? alignof(T) : COLUMN_ALIGNMENT));
+  }
+
+  template <typename U> bool operator==(const ColumnAllocator<U> &) const { return true; }
+  template <typename U> bool operator!=(const ColumnAllocator<U> &) const { return false; }
+};
+
+// type erased column so an archetype can move rows without knowing the types
+class IColumn {
+public:
+  virtual ~IColumn() = default;
+  virtual std::unique_ptr<IColumn> createEmpty() const = 0;
+
+  // append row srcRow of src (same component type) to the end of this column
+  virtual void pushFrom(IColumn &src, std::size_t srcRow) = 0;
+
+  // overwrite dstRow with row srcRow of src
+  virtual void moveFrom(IColumn &src, std::size_t srcRow, std::size_t dstRow) = 0;
+  virtual void popBack() = 0;
+};
+
+template <typename T> class Column : public IColumn {
+public:
+  std::vector<T, ColumnAllocator<T>> data;
+
+  std::unique_ptr<IColumn> createEmpty() const override {
+    auto column = std::make_unique<Column<T>>();
+    column->data.reserve(CHUNK_CAPACITY);
+    return column;
+  }
+
+  void pushFrom(IColumn &src, std::size_t srcRow) override {
+    data.push_back(std::move(static_cast<Column<T> &>(src).data[srcRow]));
   }
 
-  template <typename T> void registerComponent() {
-    componentArrays[typeid(T)] = new ComponentArray<T>();
+  void moveFrom(IColumn &src, std::size_t srcRow, std::size_t dstRow) override {
+    data[dstRow] = std::move(static_cast<Column<T> &>(src).data[srcRow]);
+  }
+
+  void popBack() override { data.pop_back(); }
+};
+
+struct Chunk {
+  std::vector<Entity> entities;                  // one per row
+  std::vector<std::unique_ptr<IColumn>> columns; // same order as Archetype::types
+
+  std::size_t size() const { return entities.size(); }
+  bool full() const { return entities.size() == CHUNK_CAPACITY; }
+};
+
+struct Archetype {
+  Signature signature;
+  std::vector<ComponentType> types;        // component type of each column
+  std::array<int, MAX_COMPONENTS> column;  // component type -> column, -1 if not here
+  std::vector<std::unique_ptr<Chunk>> chunks;
+
+  // cached transitions when adding/removing a single component type
+  std::array<Archetype *, MAX_COMPONENTS> addEdge{};
+  std::array<Archetype *, MAX_COMPONENTS> removeEdge{};
+};
+
+template <typename... Components> class ArchetypeComponentManager {
+  static_assert(sizeof...(Components) <= MAX_COMPONENTS, "Too many component types");
+
+public:
+  // rows of a chunk line up across its columns, see eachChunk()
+  static constexpr bool CHUNKED = true;
+
+private:
+
+  struct EntityLocation {
+    Archetype *archetype = nullptr; // nullptr when the entity has no components
+    std::uint32_t chunk = 0;
+    std::uint32_t row = 0;
+    Entity entity = NULL_ENTITY;    // handle living here, to catch stale handles
+  };
+
+  std::vector<std::unique_ptr<IColumn>> prototypes; // indexed by ComponentType, to create columns
+
+  std::unordered_map<Signature, std::unique_ptr<Archetype>> archetypes;
+  std::vector<Archetype *> archetypeList; // in creation order, keeps views deterministic
+
+  std::vector<EntityLocation> locations; // indexed by entity slot
+
+public:
+  ArchetypeComponentManager() {
+    (prototypes.push_back(std::make_unique<Column<Components>>()), ...);
   }
 
   template <typename T> void addComponent(Entity e, T component) {
-    getArray<T>()->insert(e, std::move(component));
+    ComponentType type = getType<T>();
+    std::uint32_t slot = entityIndex(e);
+
+    if (slot >= locations.size()) {
+      locations.resize(slot + 1);
+    }
+
+    EntityLocation loc = locations[slot];
+    assert((!loc.archetype || loc.entity == e) && "Component left behind by a destroyed entity");
+
+    // already has one, overwrite it in place
+    if (loc.archetype && loc.archetype->signature.test(type)) {
+      getColumn<T>(*loc.archetype, loc.chunk)->data[loc.row] = std::move(component);
+      return;
+    }
+
+    Archetype *dst = nullptr;
+    if (loc.archetype) {
+      dst = loc.archetype->addEdge[type];
+      if (!dst) {
+        dst = getArchetype(Signature(loc.archetype->signature).set(type));
+        loc.archetype->addEdge[type] = dst;
+      }
+    }
+    else {
+      dst = getArchetype(Signature().set(type));
+    }
+
+    Chunk &chunk = appendRow(*dst, e);
+
+    for (std::size_t c = 0; c < dst->types.size(); ++c) {
+      if (dst->types[c] == type) {
+        static_cast<Column<T> &>(*chunk.columns[c]).data.push_back(std::move(component));
+      }
+      else {
+        Chunk &src = *loc.archetype->chunks[loc.chunk];
+        chunk.columns[c]->pushFrom(*src.columns[loc.archetype->column[dst->types[c]]], loc.row);
+      }
+    }
+
+    if (loc.archetype) {
+      removeRow(*loc.archetype, loc.chunk, loc.row);
+    }
   }
 
+  // chunks have a fixed capacity so there's nothing to grow, just make sure
+  // the archetype exists before the spawn loop
+  template <typename... Comps> void reserve(std::size_t) {
+    Signature signature;
+    (signature.set(getType<Comps>()), ...);
+    getArchetype(signature);
+  }
+
+  // give an entity that has no components yet all of its components at once,
+  // straight into its final archetype instead of moving it through one
+  // archetype per component
+  template <typename... Comps> void addComponents(Entity e, Comps &&...components) {
+    std::uint32_t slot = entityIndex(e);
+    if (slot >= locations.size()) {
+      locations.resize(slot + 1);
+    }
+    assert(!locations[slot].archetype && "addComponents() is only for entities without components");
+
+    Signature signature;
+    (signature.set(getType<Comps>()), ...);
+    Archetype &dst = *getArchetype(signature);
+    Chunk &chunk = appendRow(dst, e);
+
+    (static_cast<Column<Comps> &>(*chunk.columns[dst.column[getType<Comps>()]]).data.push_back(std::move(components)),
+     ...);
+  }
+
+  // Removing a component that isn't there does nothing.
   template <typename T> void removeComponent(Entity e) {
-    getArray<T>()->remove(e);
+    if (!hasComponent<T>(e))
+      return;
+
+    ComponentType type = getType<T>();
+    EntityLocation loc = locations[entityIndex(e)];
+
+    Signature signature = Signature(loc.archetype->signature).reset(type);
+
+    if (signature.none()) {
+      // last component, the entity no longer lives in any archetype
+      removeRow(*loc.archetype, loc.chunk, loc.row);
+      locations[entityIndex(e)] = EntityLocation{};
+      return;
+    }
+
+    Archetype *dst = loc.archetype->removeEdge[type];
+    if (!dst) {
+      dst = getArchetype(signature);
+      loc.archetype->removeEdge[type] = dst;
+    }
+
+    Chunk &chunk = appendRow(*dst, e);
+    Chunk &src = *loc.archetype->chunks[loc.chunk];
+
+    for (std::size_t c = 0; c < dst->types.size(); ++c) {
+      chunk.columns[c]->pushFrom(*src.columns[loc.archetype->column[dst->types[c]]], loc.row);
+    }
+
+    removeRow(*loc.archetype, loc.chunk, loc.row);
   }
 
   template <typename T> T &getComponent(Entity e) {
-    return getArray<T>()->get(e);
+    assert(hasComponent<T>(e) && "Entity does not have component");
+    EntityLocation &loc = locations[entityIndex(e)];
+    return getColumn<T>(*loc.archetype, loc.chunk)->data[loc.row];
   }
 
   template <typename T> bool hasComponent(Entity e) {
-    return getArray<T>()->has(e);
+    std::uint32_t slot = entityIndex(e);
+    return slot < locations.size() && locations[slot].entity == e &&
+           locations[slot].archetype->signature.test(getType<T>());
+  }
+
+  // the components a live entity has
+  Signature signature(Entity e) const {
+    std::uint32_t slot = entityIndex(e);
+    if (slot >= locations.size() || locations[slot].entity != e)
+      return Signature{};
+
+    return locations[slot].archetype->signature;
+  }
+
+  // drop every component of e, called when e is destroyed
+  void removeAll(Entity e) {
+    std::uint32_t slot = entityIndex(e);
+    if (slot >= locations.size() || locations[slot].entity != e)
+      return;
+
+    EntityLocation loc = locations[slot];
+    removeRow(*loc.archetype, loc.chunk, loc.row);
+    locations[slot] = EntityLocation{};
+  }
+
+  // call fn(e) for every entity with all of the required components and none
+  // of the excluded ones, only matching archetypes are visited
+  template <typename Fn>
+  void forEachMatching(const Signature &required, const Signature &excluded, Fn &&fn) {
+    for (Archetype *archetype : archetypeList) {
+      if ((archetype->signature & required) != required || (archetype->signature & excluded).any())
+        continue;
+
+      for (auto &chunk : archetype->chunks) {
+        for (Entity e : chunk->entities) {
+          fn(e);
+        }
+      }
+    }
+  }
+
+  // call fn(e, terms...) for every entity matching the query terms Qs,
+  // reading the chunk columns directly
+  template <typename... Qs, typename Fn>
+  void each(const Signature &required, const Signature &excluded, Fn &&fn) {
+    for (Archetype *archetype : archetypeList) {
+      if ((archetype->signature & required) != required || (archetype->signature & excluded).any())
+        continue;
+
+      for (auto &chunk : archetype->chunks) {
+        for (std::size_t row = 0; row < chunk->size(); ++row) {
+          std::apply(fn, std::tuple_cat(std::tuple<Entity>(chunk->entities[row]),
+                                        fetchRow<Qs>(*archetype, *chunk, row)...));
+        }
+      }
+    }
+  }
+
+  // call fn(count, entities, terms...) once per non empty chunk matching the
+  // query terms Qs, each term is a pointer to the chunk's column (nullptr for
+  // an Optional term the archetype doesn't have)
+  template <typename... Qs, typename Fn>
+  void eachChunk(const Signature &required, const Signature &excluded, Fn &&fn) {
+    for (Archetype *archetype : archetypeList) {
+      if ((archetype->signature & required) != required || (archetype->signature & excluded).any())
+        continue;
+
+      for (auto &chunk : archetype->chunks) {
+        if (chunk->size() > 0) {
+          std::apply(fn, std::tuple_cat(std::tuple<std::size_t, const Entity *>(chunk->size(), chunk->entities.data()),
+                                        fetchColumn<Qs>(*archetype, *chunk)...));
+        }
+      }
+    }
+  }
+
+  // the argument(s) a query term hands over for e, as a tuple
+  template <typename Q> auto fetch(Entity e) {
+    using Term = QueryTerm<Q>;
+    using T = typename Term::Component;
+
+    if constexpr (Term::excluded) {
+      return std::tuple<>();
+    }
+    else if constexpr (Term::required) {
+      return std::tuple<T &>(getComponent<T>(e));
+    }
+    else {
+      return std::tuple<T *>(hasComponent<T>(e) ? &getComponent<T>(e) : nullptr);
+    }
+  }
+
+private:
+  template <typename T> static constexpr ComponentType getType() {
+    static_assert(IsOneOf<T, Components...>, "Component not registered in the World");
+    return static_cast<ComponentType>(TypeIndex<T, Components...>::value);
+  }
+
+  template <typename Q> auto fetchRow(Archetype &archetype, Chunk &chunk, std::size_t row) {
+    using Term = QueryTerm<Q>;
+    using T = typename Term::Component;
+
+    if constexpr (Term::excluded) {
+      return std::tuple<>();
+    }
+    else {
+      int column = archetype.column[getType<T>()];
+      T *component = column >= 0 ? &static_cast<Column<T> &>(*chunk.columns[column]).data[row] : nullptr;
+
+      if constexpr (Term::required) {
+        return std::tuple<T &>(*component);
+      }
+      else {
+        return std::tuple<T *>(component);
+      }
+    }
+  }
+
+  template <typename Q> auto fetchColumn(Archetype &archetype, Chunk &chunk) {
+    using Term = QueryTerm<Q>;
+    using T = typename Term::Component;
+
+    if constexpr (Term::excluded) {
+      return std::tuple<>();
+    }
+    else {
+      int column = archetype.column[getType<T>()];
+      return std::tuple<T *>(column >= 0 ? static_cast<Column<T> &>(*chunk.columns[column]).data.data() : nullptr);
+    }
+  }
+
+  template <typename T> Column<T> *getColumn(Archetype &archetype, std::uint32_t chunk) {
+    int column = archetype.column[getType<T>()];
+    assert(column >= 0 && "Archetype does not have component");
+    return static_cast<Column<T> *>(archetype.chunks[chunk]->columns[column].get());
+  }
+
+  Archetype *getArchetype(const Signature &signature) {
+    auto it = archetypes.find(signature);
+    if (it != archetypes.end()) {
+      return it->second.get();
+    }
+
+    auto archetype = std::make_unique<Archetype>();
+    archetype->signature = signature;
+    archetype->column.fill(-1);
+
+    for (ComponentType type = 0; type < prototypes.size(); ++type) {
+      if (signature.test(type)) {
+        archetype->column[type] = static_cast<int>(archetype->types.size());
+        archetype->types.push_back(type);
+      }
+    }
+
+    Archetype *result = archetype.get();
+    archetypeList.push_back(result);
+    archetypes.emplace(signature, std::move(archetype));
+    return result;
+  }
+
+  // reserve a row at the end of the archetype for entity e, the caller fills
+  // every column
+  Chunk &appendRow(Archetype &archetype, Entity e) {
+    if (archetype.chunks.empty() || archetype.chunks.back()->full()) {
+      auto chunk = std::make_unique<Chunk>();
+      chunk->entities.reserve(CHUNK_CAPACITY);
+      for (ComponentType type : archetype.types) {
+        chunk->columns.push_back(prototypes[type]->createEmpty());
+      }
+      archetype.chunks.push_back(std::move(chunk));
+    }
+
+    Chunk &chunk = *archetype.chunks.back();
+    locations[entityIndex(e)] = EntityLocation{&archetype,
+                                               static_cast<std::uint32_t>(archetype.chunks.size() - 1),
+                                               static_cast<std::uint32_t>(chunk.size()), e};
+    chunk.entities.push_back(e);
+    return chunk;
+  }
+
+  // swap and pop across the whole archetype: the last row of the last chunk
+  // moves into the hole so the chunks stay packed
+  void removeRow(Archetype &archetype, std::uint32_t chunkIndex, std::uint32_t row) {
+    Chunk &chunk = *archetype.chunks[chunkIndex];
+    Chunk &last = *archetype.chunks.back();
+    std::uint32_t lastRow = static_cast<std::uint32_t>(last.size() - 1);
+
+    if (&chunk != &last || row != lastRow) {
+      for (std::size_t c = 0; c < archetype.types.size(); ++c) {
+        chunk.columns[c]->moveFrom(*last.columns[c], lastRow, row);
+      }
+
+      Entity moved = last.entities[lastRow];
+      chunk.entities[row] = moved;
+      locations[entityIndex(moved)].chunk = chunkIndex;
+      locations[entityIndex(moved)].row = row;
+    }
+
+    for (auto &column : last.columns) {
+      column->popBack();
+    }
+    last.entities.pop_back();
+
+    // keep one empty chunk around, bullets are created and destroyed in bursts
+    if (last.entities.empty() && archetype.chunks.size() > 1) {
+      archetype.chunks.pop_back();
+    }
+  }
+};
+
+#if defined(ROCI_ECS_ARCHETYPE)
+template <typename... Components>
+using ComponentStorage = ArchetypeComponentManager<Components...>;
+#else
+template <typename... Components>
+using ComponentStorage = ComponentManager<Components...>;
+#endif
+
+///////////////////////////////////////////////////////////////////////////////
+// GROUPS
+///////////////////////////////////////////////////////////////////////////////
+
+// A dense list of entities with O(1) insert, erase and lookup, the members
+// of a group or change tracker
+class EntitySet {
+public:
+  // false if e was already in the set
+  bool insert(Entity e) {
+    if (contains(e))
+      return false;
+
+    std::uint32_t slot = entityIndex(e);
+    if (slot >= index.size()) {
+      index.resize(slot + 1, NOT_MEMBER);
+    }
+    index[slot] = static_cast<std::uint32_t>(members.size());
+    members.push_back(e);
+    return true;
+  }
+
+  void erase(Entity e) {
+    if (!contains(e))
+      return;
+
+    // swap and pop, same as the component arrays
+    std::uint32_t i = index[entityIndex(e)];
+    Entity last = members.back();
+    members[i] = last;
+    index[entityIndex(last)] = i;
+    members.pop_back();
+    index[entityIndex(e)] = NOT_MEMBER;
+  }
+
+  bool contains(Entity e) const {
+    std::uint32_t slot = entityIndex(e);
+    return slot < index.size() && index[slot] != NOT_MEMBER && members[index[slot]] == e;
   }
 
-  template <typename T> ComponentArray<T> *getArray() {
-    // `it` is an iterator. It “points” to the map entry whose key is
-    // type_index(T).
-    auto it = componentArrays.find(typeid(T));
-    assert(it != componentArrays.end() && "Component not registered");
+  // costs the number of members, not the number of entities
+  void clear() {
+    for (Entity e : members) {
+      index[entityIndex(e)] = NOT_MEMBER;
+    }
+    members.clear();
+  }
+
+  const std::vector<Entity> &entities() const { return members; }
+
+private:
+  static constexpr std::uint32_t NOT_MEMBER = 0xFFFFFFFF;
+
+  std::vector<Entity> members;
+  std::vector<std::uint32_t> index; // entity slot -> position in members
+};
+
+// A group is a persistent view: all entities with ALL of a set of components.
+// It is built the first time it is asked for, after that the Coordinator keeps
+// it up to date as components are added and removed, so iterating a group
+// doesn't rebuild or allocate anything.
+class Group {
+public:
+  // starts empty, the World adds the entities that already match
+  explicit Group(Signature required) : required(required) {}
+
+  // one of the group's components has been added to e, which now has signature
+  void componentAdded(Entity e, const Signature &signature) {
+    if ((signature & required) == required) {
+      members.insert(e);
+    }
+  }
+
+  // one of the group's components has been removed from e, or e is destroyed
+  void componentRemoved(Entity e) { members.erase(e); }
+
+  const std::vector<Entity> &entities() const { return members.entities(); }
+
+private:
+  Signature required; // components a member must have
+  EntitySet members;
+};
+
+///////////////////////////////////////////////////////////////////////////////
+// CHANGE TRACKING
+///////////////////////////////////////////////////////////////////////////////
+
+// The entities whose component was added or changed since the tracker was
+// last cleared, each listed once. A system keeps its own tracker (from
+// World::changed<T>() or World::added<T>()), works through entities() when
+// it runs and then clears it, so the cost follows the number of changes
+// rather than the number of entities. Entities that lose the component or
+// are destroyed drop out on their own.
+class ChangeTracker {
+public:
+  const std::vector<Entity> &entities() const { return changes.entities(); }
+  bool empty() const { return changes.entities().empty(); }
+
+  void clear() { changes.clear(); }
+
+  // the World's side
+  void record(Entity e) { changes.insert(e); }
+  void forget(Entity e) { changes.erase(e); }
+
+private:
+  EntitySet changes;
+};
+
+///////////////////////////////////////////////////////////////////////////////
+// COMMAND BUFFER
+///////////////////////////////////////////////////////////////////////////////
+
+// Structural changes queued while a system is running and applied together
+// when the World is flushed. Nothing moves in the component arrays or groups
+// until then, so component references and group iteration stay good for the
+// whole system run.
+//
+// createEntity hands out the entity straight away (that doesn't touch any
+// component storage) so components can be queued for it. destroyEntity makes
+// the entity invalid straight away so other systems skip it, it is actually
+// destroyed at the flush. A flush applies the spawns, then all the adds
+// (grouped by component type), then the removes, then the destroys.
+template <typename World, typename... Components> class CommandBuffer {
+  World &world;
+
+  std::tuple<std::vector<std::pair<Entity, Components>>...> adds; // one queue per type
+  std::vector<std::pair<Entity, std::size_t>> removes;           // entity, component id
+  std::vector<Entity> destroys;
+  std::vector<std::function<void()>> spawns;                      // World::spawn() calls
 
-    // return the ComponentArray<T> pointer
-    return static_cast<ComponentArray<T> *>(it->second);
+  template <typename T> static void removeOne(World &world, Entity e) {
+    world.template removeComponent<T>(e);
   }
 
-  // returns a std::array of IComponentArray* (or ComponentArray<Base>*)
-  // one for each Comps in the pack
-  template <typename... Comps> auto getArrays() {
-    return std::array<IComponentArray *, sizeof...(Comps)>{
-        getArray<Comps>()...};
+  // component id -> removeComponent<T>
+  static constexpr void (*removers[])(World &, Entity) = {&removeOne<Components>...};
+
+public:
+  explicit CommandBuffer(World &world) : world(world) {}
+
+  Entity createEntity(const std::string &name) { return world.createEntity(name); }
+  Entity createEntity(NameId name) { return world.createEntity(name); }
+
+  template <typename T> void addComponent(Entity e, T component) {
+    static_assert(IsOneOf<T, Components...>, "Component not registered in the World");
+    std::get<std::vector<std::pair<Entity, T>>>(adds).emplace_back(e, std::move(component));
+  }
+
+  template <typename T> void removeComponent(Entity e) {
+    static_assert(IsOneOf<T, Components...>, "Component not registered in the World");
+    removes.emplace_back(e, TypeIndex<T, Components...>::value);
+  }
+
+  // World::spawn() at the flush, the entities don't exist until then so make
+  // is copied and run there
+  template <typename Fn> void spawn(std::size_t count, NameId name, Fn make) {
+    spawns.push_back([this, count, name, make]() mutable { world.spawn(count, name, make); });
+  }
+
+  // destroying an entity twice in a frame is fine, the second is ignored
+  void destroyEntity(Entity e) {
+    if (!world.valid(e))
+      return;
+
+    world.entityMgr.markPendingDestroy(e);
+    destroys.push_back(e);
+  }
+
+  // apply everything queued, commands for entities that are already gone are
+  // dropped
+  void flush() {
+    for (auto &spawn : spawns) {
+      spawn();
+    }
+    spawns.clear();
+
+    std::apply([this](auto &...queues) { (applyAdds(queues), ...); }, adds);
+
+    for (auto &[e, id] : removes) {
+      if (world.entityMgr.exists(e)) {
+        removers[id](world, e);
+      }
+    }
+    removes.clear();
+
+    for (Entity e : destroys) {
+      if (world.entityMgr.exists(e)) {
+        world.destroyEntity(e);
+      }
+    }
+    destroys.clear();
+  }
+
+private:
+  template <typename T> void applyAdds(std::vector<std::pair<Entity, T>> &queue) {
+    for (auto &[e, component] : queue) {
+      if (world.entityMgr.exists(e)) {
+        world.addComponent(e, std::move(component));
+      }
+    }
+    queue.clear();
   }
 };
 
 ///////////////////////////////////////////////////////////////////////////////
 // Coordinator (Facade)
 ///////////////////////////////////////////////////////////////////////////////
-class Coordinator {
+// The game's Coordinator is a World over all of its component types, see the
+// alias at the bottom of components.hpp. Using a component type that isn't in
+// the list is a compile error.
+template <typename... Components> class World {
+  using Storage = ComponentStorage<Components...>;
+  using Commands = CommandBuffer<World, Components...>;
+  friend Commands;
+
   EntityManager entityMgr;
-  ComponentManager compMgr;
+  Storage compMgr;
+  Commands commandBuffer{*this};
+  ThreadPool threadPool;
+
+  // registered groups by the components they require, and the groups to
+  // update when a component type changes (indexed by component id)
+  std::unordered_map<Signature, std::unique_ptr<Group>> groups;
+  std::array<std::vector<Group *>, sizeof...(Components)> groupsByComponent;
+
+  // change trackers handed out by changed()/added(), and the ones to tell
+  // about each component type (indexed by component id)
+  std::vector<std::unique_ptr<ChangeTracker>> trackers;
+  std::array<std::vector<ChangeTracker *>, sizeof...(Components)> changedTrackers;
+  std::array<std::vector<ChangeTracker *>, sizeof...(Components)> addedTrackers;
+
+  // observer hooks, by component id for add/remove
+  using Observer = std::function<void(Entity)>;
+  std::array<std::vector<Observer>, sizeof...(Components)> addObservers;
+  std::array<std::vector<Observer>, sizeof...(Components)> removeObservers;
+  std::vector<Observer> destroyObservers;
+
+  template <typename T> static constexpr std::size_t componentId() {
+    static_assert(IsOneOf<T, Components...>, "Component not registered in the World");
+    return TypeIndex<T, Components...>::value;
+  }
+
+  // the masks of the components query terms Qs require and exclude
+  template <typename... Qs> static Signature requiredOf() {
+    Signature signature;
+    ((QueryTerm<Qs>::required ? signature.set(componentId<typename QueryTerm<Qs>::Component>())
+                              : signature),
+     ...);
+    return signature;
+  }
+
+  template <typename... Qs> static Signature excludedOf() {
+    Signature signature;
+    ((QueryTerm<Qs>::excluded ? signature.set(componentId<typename QueryTerm<Qs>::Component>())
+                              : signature),
+     ...);
+    return signature;
+  }
+
+  template <typename... Qs> static constexpr bool hasRequiredTerm() {
+    return (QueryTerm<Qs>::required || ...);
+  }
+
+  // a query term as a pointer, for the single entity runs of eachChunk()
+  template <typename T> static T *pointerTo(T &component) { return &component; }
+  template <typename T> static T *pointerTo(T *component) { return component; }
+
+  // the pointer a query term becomes in eachChunk(), as a tuple
+  template <typename Q> static auto termPointer() {
+    if constexpr (QueryTerm<Q>::excluded) {
+      return std::tuple<>();
+    }
+    else {
+      return std::tuple<typename QueryTerm<Q>::Component *>();
+    }
+  }
+
+  ChangeTracker &newTracker(std::vector<ChangeTracker *> &list) {
+    trackers.push_back(std::make_unique<ChangeTracker>());
+    list.push_back(trackers.back().get());
+    return *trackers.back();
+  }
+
+  template <typename Fn, typename... Batch>
+  void spawnBatch(std::size_t count, NameId name, Fn &make, std::tuple<Batch...> *) {
+    compMgr.template reserve<Batch...>(count);
+    const Signature signature = requiredOf<Batch...>();
+
+    for (std::size_t i = 0; i < count; ++i) {
+      Entity e = entityMgr.create(name);
+      std::apply([&](Batch &&...components) { compMgr.addComponents(e, std::move(components)...); }, make(i, e));
+      componentsAdded(e, signature);
+    }
+  }
+
+  // tell the groups, trackers and observers about all of a new entity's
+  // components at once
+  void componentsAdded(Entity e, const Signature &signature) {
+    for (std::size_t id = 0; id < sizeof...(Components); ++id) {
+      if (signature.test(id)) {
+        for (Group *group : groupsByComponent[id]) {
+          group->componentAdded(e, signature);
+        }
+        for (ChangeTracker *tracker : addedTrackers[id]) {
+          tracker->record(e);
+        }
+        for (ChangeTracker *tracker : changedTrackers[id]) {
+          tracker->record(e);
+        }
+      }
+    }
+
+    for (std::size_t id = 0; id < sizeof...(Components); ++id) {
+      if (signature.test(id)) {
+        for (auto &observer : addObservers[id]) {
+          observer(e);
+        }
+      }
+    }
+  }
+
+  // the group for a mask, registered and filled on first use
+  Group &groupFor(const Signature &required) {
+    auto &group = groups[required];
+
+    if (!group) {
+      group = std::make_unique<Group>(required);
+      compMgr.forEachMatching(required, Signature(), [&](Entity e) { group->componentAdded(e, required); });
+
+      for (std::size_t id = 0; id < sizeof...(Components); ++id) {
+        if (required.test(id)) {
+          groupsByComponent[id].push_back(group.get());
+        }
+      }
+    }
+
+    return *group;
+  }
+
+  // range-for over a group, skipping excluded entities and yielding a tuple
+  // of (Entity, terms...) per entity
+  template <typename... Qs> class Range {
+  public:
+    class iterator {
+    public:
+      iterator(World &world, const std::vector<Entity> &members, std::size_t i, Signature excluded)
+          : world(world), members(members), i(i), excluded(excluded) {
+        skipExcluded();
+      }
+
+      auto operator*() const {
+        Entity e = members[i];
+        return std::tuple_cat(std::tuple<Entity>(e), world.compMgr.template fetch<Qs>(e)...);
+      }
+
+      iterator &operator++() {
+        ++i;
+        skipExcluded();
+        return *this;
+      }
+
+      bool operator!=(const iterator &other) const { return i != other.i; }
+
+    private:
+      World &world;
+      const std::vector<Entity> &members;
+      std::size_t i;
+      Signature excluded;
+
+      void skipExcluded() {
+        if (excluded.none())
+          return;
+        while (i < members.size() && (world.signature(members[i]) & excluded).any()) {
+          ++i;
+        }
+      }
+    };
+
+    Range(World &world, const std::vector<Entity> &members, Signature excluded)
+        : world(world), members(members), excluded(excluded) {}
+
+    iterator begin() const { return iterator(world, members, 0, excluded); }
+    iterator end() const { return iterator(world, members, members.size(), Signature()); }
+
+  private:
+    World &world;
+    const std::vector<Entity> &members;
+    Signature excluded;
+  };
 
 public:
+  // threads is the size of the thread pool, the calling thread included
+  explicit World(unsigned threads = std::thread::hardware_concurrency()) : threadPool(threads) {}
+
   Entity createEntity() { return entityMgr.create(); }
-  Entity createEntity(std::string name) { return entityMgr.create(name); }
-  void destroyEntity(Entity e) { entityMgr.destroy(e); }
+  Entity createEntity(const std::string &name) { return entityMgr.create(name); }
+
+  // prefer this for entities created often, intern the name once up front
+  Entity createEntity(NameId name) { return entityMgr.create(name); }
+
+  // Spawn: create count entities named name in one go. make(i, e) returns
+  // the components of the i'th entity e as a std::tuple, e.g.
+  //   ecs.spawn(n, bulletName, [&](std::size_t i, Entity e) {
+  //     return std::make_tuple(Position{...}, Velocity{...});
+  //   });
+  // The component storage grows once for the whole batch and each entity
+  // gets all of its components at once, so groups, trackers and observers
+  // hear about it once. Use commands().spawn() from inside systems.
+  template <typename Fn> void spawn(std::size_t count, NameId name, Fn &&make) {
+    using Batch = decltype(make(std::size_t(0), NULL_ENTITY));
+    spawnBatch(count, name, make, static_cast<Batch *>(nullptr));
+  }
+
+  // the NameId for a name, for creating and comparing without strings
+  NameId internName(const std::string &name) { return entityMgr.intern(name); }
+
+  // structural changes to apply at the next flush(), use this from inside
+  // systems that are iterating groups
+  Commands &commands() { return commandBuffer; }
+
+  // the sync point: apply everything queued on commands()
+  void flush() { commandBuffer.flush(); }
+
+  // destroys e and any components it still has, handles to it become invalid.
+  // Only the components in e's signature, and the groups that use them, are
+  // touched.
+  void destroyEntity(Entity e) {
+    Signature signature = compMgr.signature(e);
+
+    for (auto &observer : destroyObservers) {
+      observer(e);
+    }
 
-  template <typename T> void registerComponent() {
-    compMgr.registerComponent<T>();
+    for (std::size_t id = 0; id < sizeof...(Components); ++id) {
+      if (signature.test(id)) {
+        for (auto &observer : removeObservers[id]) {
+          observer(e);
+        }
+        for (Group *group : groupsByComponent[id]) {
+          group->componentRemoved(e);
+        }
+        for (ChangeTracker *tracker : changedTrackers[id]) {
+          tracker->forget(e);
+        }
+        for (ChangeTracker *tracker : addedTrackers[id]) {
+          tracker->forget(e);
+        }
+      }
+    }
+
+    compMgr.removeAll(e);
+    entityMgr.destroy(e);
   }
 
   template <typename T> void addComponent(Entity e, T comp) {
-    compMgr.addComponent<T>(e, std::move(comp));
+    auto &removeObserversForT = removeObservers[componentId<T>()];
+    if (!removeObserversForT.empty() && hasComponent<T>(e)) {
+      // replacing it, to an observer that's a remove then an add
+      for (auto &observer : removeObserversForT) {
+        observer(e);
+      }
+    }
+
+    compMgr.template addComponent<T>(e, std::move(comp));
+
+    for (auto &observer : addObservers[componentId<T>()]) {
+      observer(e);
+    }
+
+    auto &groupsForT = groupsByComponent[componentId<T>()];
+    if (!groupsForT.empty()) {
+      Signature signature = compMgr.signature(e);
+      for (Group *group : groupsForT) {
+        group->componentAdded(e, signature);
+      }
+    }
+
+    // a new component counts as changed too
+    for (ChangeTracker *tracker : addedTrackers[componentId<T>()]) {
+      tracker->record(e);
+    }
+    markChanged<T>(e);
   }
 
   template <typename T> void removeComponent(Entity e) {
-    compMgr.removeComponent<T>(e);
+    auto &removeObserversForT = removeObservers[componentId<T>()];
+    if (!removeObserversForT.empty() && hasComponent<T>(e)) {
+      for (auto &observer : removeObserversForT) {
+        observer(e);
+      }
+    }
+
+    compMgr.template removeComponent<T>(e);
+
+    for (Group *group : groupsByComponent[componentId<T>()]) {
+      group->componentRemoved(e);
+    }
+    for (ChangeTracker *tracker : changedTrackers[componentId<T>()]) {
+      tracker->forget(e);
+    }
+    for (ChangeTracker *tracker : addedTrackers[componentId<T>()]) {
+      tracker->forget(e);
+    }
+  }
+
+  // Change detection: writes through getComponent()/each() aren't seen, a
+  // system that changes a T others track says so with markChanged() or makes
+  // the change with patch(). Not from inside parallelEach().
+  template <typename T> void markChanged(Entity e) {
+    for (ChangeTracker *tracker : changedTrackers[componentId<T>()]) {
+      tracker->record(e);
+    }
+  }
+
+  // fn(T &) on e's T, then mark it changed
+  template <typename T, typename Fn> void patch(Entity e, Fn &&fn) {
+    fn(getComponent<T>(e));
+    markChanged<T>(e);
+  }
+
+  // Observers: keep an index outside the ECS in step with it instead of
+  // rescanning. onAdd runs fn(e, T &) once e has its new T, onRemove runs
+  // fn(e, T &) while e still has the T it's losing (also when e is
+  // destroyed, or its T replaced by addComponent), onDestroy runs fn(e)
+  // before any of that. They run inside the structural change, so an
+  // observer must not make structural changes itself, queue them on
+  // commands() instead.
+  template <typename T, typename Fn> void onAdd(Fn fn) {
+    addObservers[componentId<T>()].push_back([this, fn](Entity e) { fn(e, getComponent<T>(e)); });
+  }
+
+  template <typename T, typename Fn> void onRemove(Fn fn) {
+    removeObservers[componentId<T>()].push_back([this, fn](Entity e) { fn(e, getComponent<T>(e)); });
   }
 
+  template <typename Fn> void onDestroy(Fn fn) { destroyObservers.push_back(fn); }
+
+  // a new tracker of the entities whose T is added or changed from now on,
+  // one per system that wants to know. Owned by the World.
+  template <typename T> ChangeTracker &changed() { return newTracker(changedTrackers[componentId<T>()]); }
+
+  // a new tracker of the entities that get a T from now on
+  template <typename T> ChangeTracker &added() { return newTracker(addedTrackers[componentId<T>()]); }
+
   template <typename T> T &getComponent(Entity e) {
-    return compMgr.getComponent<T>(e);
+    return compMgr.template getComponent<T>(e);
   }
 
   template <typename T> bool hasComponent(Entity e) {
-    return compMgr.hasComponent<T>(e);
+    return compMgr.template hasComponent<T>(e);
   }
 
-  std::string getEntityName(Entity e) { return entityMgr.getName(e); }
+  // the components e has, one bit per component id (valid entities only)
+  Signature signature(Entity e) const { return compMgr.signature(e); }
+
+  const std::string &getEntityName(Entity e) const { return entityMgr.getName(e); }
+  NameId getEntityNameId(Entity e) const { return entityMgr.getNameId(e); }
 
-  bool isAlive(Entity e) { return entityMgr.isAlive(e); }
+  // cheap check that a stored handle still refers to a live entity
+  bool valid(Entity e) const { return entityMgr.valid(e); }
+
+  // number of live entities, the most there have been at once, and how many
+  // the entity manager has room for before it allocates another page
+  std::uint32_t entityCount() const { return entityMgr.size(); }
+  std::uint32_t peakEntityCount() const { return entityMgr.peak(); }
+  std::uint32_t entityCapacity() const { return entityMgr.capacity(); }
 
   // View: get all entities with ALL of the listed components
-  // Variadic template declaration
+  // builds a new list on every call, prefer each() for anything run per frame
   template <typename First, typename... Rest> std::vector<Entity> view() {
+    std::vector<Entity> entities;
+    compMgr.forEachMatching(requiredOf<First, Rest...>(), Signature(), [&](Entity e) { entities.push_back(e); });
+    return entities;
+  }
 
-    auto *firstArr = compMgr.getArray<First>();
-    auto list = firstArr->getEntities();
+  // Each: call fn(Entity, terms...) for every entity matching the query, e.g.
+  //   ecs.each<Position, Optional<Velocity>, Exclude<TimeFired>>(
+  //       [](Entity e, Position &p, Velocity *v) { ... });
+  // Needs at least one required term. Nothing is allocated, the storage is
+  // walked in place, so structural changes (add/remove/destroy) must go
+  // through commands() until the loop is done.
+  template <typename... Qs, typename Fn> void each(Fn &&fn) {
+    static_assert(hasRequiredTerm<Qs...>(), "each() needs at least one required component");
+    compMgr.template each<Qs...>(requiredOf<Qs...>(), excludedOf<Qs...>(), std::forward<Fn>(fn));
+  }
 
-    std::vector<Entity> result;
-    result.reserve(list.size());
+  // ParallelEach: the same as each(), but the matching entities are split in
+  // chunks across the thread pool. fn runs concurrently, so it may only write
+  // to the components it was handed (reading other entities is fine as long
+  // as nothing writes them), and it mustn't make structural changes at all,
+  // not even through commands(). For scratch data use
+  // scratch[ThreadPool::currentWorker()] with threads().size() slots.
+  // Backed by the group of the required components, like range().
+  //
+  // The default grain suits a cheap body (a few sums), it only splits the
+  // loop once there are hundreds of entities. A body that costs a lot per
+  // entity (a torpedo's guidance) should pass a small grain, the entities
+  // per task, so even a few dozen of them are spread over the workers.
+  template <typename... Qs, typename Fn> void parallelEach(Fn &&fn) {
+    static_assert(hasRequiredTerm<Qs...>(), "parallelEach() needs at least one required component");
 
-    for (Entity e : list) {
-      // check the rest of the pack of components
-      if ((compMgr.getArray<Rest>()->has(e) && ...)) {
-        result.push_back(e);
+    // a few chunks per worker so stealing can even them out, but not so
+    // small that the queueing costs more than the work
+    std::size_t members = groupFor(requiredOf<Qs...>()).entities().size();
+    parallelEach<Qs...>(std::max<std::size_t>(members / (threadPool.size() * 4), 256), std::forward<Fn>(fn));
+  }
+
+  template <typename... Qs, typename Fn> void parallelEach(std::size_t grain, Fn &&fn) {
+    static_assert(hasRequiredTerm<Qs...>(), "parallelEach() needs at least one required component");
+    const std::vector<Entity> &members = groupFor(requiredOf<Qs...>()).entities();
+    const Signature excluded = excludedOf<Qs...>();
+
+    threadPool.parallelFor(members.size(), grain, [&](std::size_t begin, std::size_t end) {
+      for (std::size_t i = begin; i < end; ++i) {
+        Entity e = members[i];
+        if (excluded.any() && (compMgr.signature(e) & excluded).any())
+          continue;
+        std::apply(fn, std::tuple_cat(std::tuple<Entity>(e), compMgr.template fetch<Qs>(e)...));
       }
+    });
+  }
+
+  // EachChunk: each() a run of rows at a time, for loops that want to use
+  // SIMD. fn(count, entities, terms...) gets a pointer per term to count
+  // consecutive components, lined up with entities (nullptr for an Optional
+  // term the run doesn't have), e.g.
+  //   ecs.eachChunk<Position, Velocity>(
+  //       [](std::size_t n, const Entity *e, Position *p, Velocity *v) { ... });
+  // The archetype storage hands over whole chunks, with aligned columns. The
+  // sparse arrays each keep their own order, so there every run is a single
+  // entity.
+  template <typename... Qs, typename Fn> void eachChunk(Fn &&fn) {
+    static_assert(hasRequiredTerm<Qs...>(), "eachChunk() needs at least one required component");
+    if constexpr (Storage::CHUNKED) {
+      compMgr.template eachChunk<Qs...>(requiredOf<Qs...>(), excludedOf<Qs...>(), std::forward<Fn>(fn));
+    }
+    else {
+      each<Qs...>([&](Entity e, auto &&...terms) { fn(std::size_t(1), &e, pointerTo(terms)...); });
     }
-    return result;
+  }
+
+  // ParallelEachChunk: eachChunk() with the runs spread over the thread
+  // pool, the same rules as parallelEach() apply to fn
+  template <typename... Qs, typename Fn> void parallelEachChunk(Fn &&fn) {
+    static_assert(hasRequiredTerm<Qs...>(), "parallelEachChunk() needs at least one required component");
+    if constexpr (Storage::CHUNKED) {
+      using Run = decltype(std::tuple_cat(std::tuple<std::size_t, const Entity *>(), termPointer<Qs>()...));
+      // kept between frames. The workers have their own (empty) copy of a
+      // thread_local, so they read it through this reference.
+      static thread_local std::vector<Run> scratch;
+      std::vector<Run> &runs = scratch;
+      runs.clear();
+
+      compMgr.template eachChunk<Qs...>(requiredOf<Qs...>(), excludedOf<Qs...>(),
+                                        [&](std::size_t count, const Entity *entities, auto *...terms) {
+                                          runs.emplace_back(count, entities, terms...);
+                                        });
+
+      threadPool.parallelFor(runs.size(), 1, [&](std::size_t begin, std::size_t end) {
+        for (std::size_t i = begin; i < end; ++i) {
+          std::apply(fn, runs[i]);
+        }
+      });
+    }
+    else {
+      parallelEach<Qs...>([&](Entity e, auto &&...terms) { fn(std::size_t(1), &e, pointerTo(terms)...); });
+    }
+  }
+
+  // the World's worker threads, for data parallel loops that aren't a query
+  ThreadPool &threads() { return threadPool; }
+
+  // true if eachChunk() hands out whole chunks (archetype storage), false if
+  // every run is a single entity (sparse sets)
+  static constexpr bool CHUNKED = Storage::CHUNKED;
+
+  // the mask of the listed components, one bit per component id
+  template <typename... Comps> static Signature componentMask() { return requiredOf<Comps...>(); }
+
+  // Range: the same query for a range for, e.g.
+  //   for (auto [e, p, v] : ecs.range<Position, Velocity>()) { ... }
+  // Backed by the group of the required components, so it's registered on
+  // first use. Same rule as each(), queue structural changes on commands().
+  template <typename... Qs> Range<Qs...> range() {
+    static_assert(hasRequiredTerm<Qs...>(), "range() needs at least one required component");
+    return Range<Qs...>(*this, groupFor(requiredOf<Qs...>()).entities(), excludedOf<Qs...>());
+  }
+
+  // Group: the persistent list of all entities with ALL of the listed
+  // components. Registered on first use and kept up to date afterwards.
+  // Don't add/remove the group's components or destroy entities while
+  // iterating it with a range for, either copy it or iterate it backwards by
+  // index (a removal only moves the last member into the hole).
+  template <typename First, typename... Rest> const std::vector<Entity> &group() {
+    return groupFor(requiredOf<First, Rest...>()).entities();
   }
 
   // get all entities that have the given name i.e. all Bullets or Torpedos
-  std::vector<Entity> getEntitiesByName(std::string ename) {
-    return entityMgr.getEntitiesByName(ename);
+  // Don't create or destroy entities with that name while iterating the list.
+  const std::vector<Entity> &getEntitiesByName(NameId name) const {
+    return entityMgr.getEntitiesByName(name);
+  }
+
+  const std::vector<Entity> &getEntitiesByName(const std::string &name) const {
+    return entityMgr.getEntitiesByName(entityMgr.findName(name));
   }
 };
@@ -1,4 +1,5 @@
 #pragma once
+#include "assets.hpp"
 #include "components.hpp"
 #include "ecs.hpp"
 #include "ballistics.hpp"
@@ -8,20 +9,21 @@
 #include <iostream>
 #include <cmath>
 #include <SFML/Graphics.hpp>
-#include <SFML/Audio.hpp>
 #include <unistd.h>
 
 class EnemyAI {
 
 public:
   EnemyAI(Coordinator &ecs, Entity enemy, BulletFactory bulletFactory,
-          TorpedoFactory torpedoFactory, sf::Sound pdcFireSoundPlayer) :
+          TorpedoFactory torpedoFactory, SoundEffect pdcFireSoundPlayer,
+          const IncomingTorpedoes &incoming) :
     ecs(ecs),
     enemy(enemy),
     bulletFactory(bulletFactory),
     torpedoFactory(torpedoFactory),
     pdcFireSoundPlayer(pdcFireSoundPlayer),
-    pdcTargeting(ecs, enemy, bulletFactory, pdcFireSoundPlayer) {
+    incoming(incoming),
+    pdcTargeting(ecs, enemy, bulletFactory, pdcFireSoundPlayer, incoming) {
 
     // allow immediate torpedo barrage launch
  
@@ -70,7 +72,7 @@ public:
       state = State::DISABLED;
       std::cout << "EnemyAI: " << enemy << " EnemyAI state: DISABLED (health <= 0)" << std::endl;
     }
-    else if (torpedoThreatDetect(ecs, enemy, pdcTorpedoTrackingRange) && pdc1rounds > 0) {
+    else if (torpedoThreatDetect(ecs, incoming, enemy, pdcTorpedoTrackingRange) && pdc1rounds > 0) {
       state = State::DEFENCE_PDC;
       // std::cout << "EnemyAI state: DEFENCE_PDC" << std::endl;
     }
@@ -337,7 +339,8 @@ public:
   Entity enemy;
   BulletFactory bulletFactory;
   TorpedoFactory torpedoFactory;
-  sf::Sound pdcFireSoundPlayer;
+  SoundEffect pdcFireSoundPlayer;
+  const IncomingTorpedoes &incoming;
   PdcTargeting pdcTargeting;
 
   const float close_distance          = 50000.f;  // will close rarther than flip and burn
@@ -374,16 +377,11 @@ public:
     sf::Vector2f forward = normalizeVector(enemyVel.value);
     sf::Vector2f lookAheadPos = enemyPos.value + forward * lookAheadDistance;
 
-    for (auto &ec : ecs.view<Position, Collision>()) {
+    // only ships and asteroids, bullets have TimeFired and torpedoes TorpedoControl
+    ecs.each<Position, Collision, Exclude<TimeFired>, Exclude<TorpedoControl>>(
+        [&](Entity, Position &position, Collision &) {
 
-      auto &collision = ecs.getComponent<Collision>(ec);
-
-      if (collision.ctype != CollisionType::ASTEROID &&
-          collision.ctype != CollisionType::SHIP) {
-        continue; // skip non-asteroid entities
-      }
-
-      auto &collisionPos = ecs.getComponent<Position>(ec).value;
+      auto &collisionPos = position.value;
 
       float dist = distance(lookAheadPos, collisionPos);
 
@@ -395,7 +393,7 @@ public:
         // std::cout << "Avoidance vector: " << avoidanceVector.x << ", " << avoidanceVector.y << std::endl;
         enemyVel.value += avoidanceVector; // apply avoidance force
       }
-    }
+    });
 
   }
 
@@ -3,10 +3,12 @@
 #include "ecs.hpp"
 #include "torpedotarget.hpp"
 #include <SFML/Graphics.hpp>
+#include <string>
+#include <unordered_map>
 
 class HUD {
 public:
-  HUD(Coordinator& ecs, Entity player, TorpedoTargeting &torpedoTargeting);
+  HUD(Coordinator& ecs, Entity player, TorpedoTargeting &torpedoTargeting, const IncomingTorpedoes &incoming);
 
   ~HUD() = default;
 
@@ -14,11 +16,20 @@ public:
 
   void toggleOverlay();
 
+  // shown while the sim runs faster than real time
+  void setTimeWarp(float factor, float effective);
+
 private:
   sf::Font font;
   Coordinator& ecs;
   Entity player;
   TorpedoTargeting &torpedoTargeting;
+  const IncomingTorpedoes &incoming;
+  NameId torpedoName;
+
+  // sidebar health text per ship, rebuilt only when its Health changes
+  ChangeTracker &healthChanged;
+  std::unordered_map<Entity, std::string> healthText;
  
   u_int16_t screenWidth;
   u_int16_t screenHeight;
@@ -29,9 +40,13 @@ private:
 
   bool displayOverlay = true; 
 
+  float timeWarp = 1.f;
+  float effectiveTimeWarp = 1.f;
+
   enum class SidebarPosition {LEFT_TOP, RIGHT_TOP, LEFT_MIDDLE, RIGHT_MIDDLE, LEFT_BOTTOM, RIGHT_BOTTOM};
 
   void DrawTorpedoThreat(sf::RenderWindow & window);
+  void DrawTimeWarp(sf::RenderWindow & window);
   void DrawTorpedoTargetingText(sf::RenderWindow & window);
   void DrawSidebarText(sf::RenderWindow& window, Entity e, SidebarPosition pos);
   void DrawShipNames (sf::RenderWindow& window, Entity e, float zoomFactor);
@@ -0,0 +1,147 @@
+#pragma once
+#include "components.hpp"
+#include "ecs.hpp"
+#include <cstddef>
+#include <type_traits>
+
+#if defined(__AVX2__)
+#include <immintrin.h>
+#elif defined(__SSE2__) || defined(_M_X64)
+#include <emmintrin.h>
+#endif
+
+///////////////////////////////////////////////////////////////////////////////
+// KINEMATICS
+///////////////////////////////////////////////////////////////////////////////
+// The physics stage, A->V->P and the rotation, fused into one pass over the
+// moving entities. It runs on the runs of rows eachChunk() hands out: with
+// the archetype storage a chunk's Position, Velocity, Acceleration and
+// Rotation columns are aligned arrays that line up row for row, so the x/y
+// pairs are integrated straight out of them with SIMD.
+//
+// The sparse set arrays each keep their own order, so a fused pass there
+// only ever gets runs of one entity and never reaches the kernel, and it's
+// slower than a loop per component. With that storage updateKinematics()
+// keeps the loops: A->V, V->P, the rotation, then the orientations.
+//
+// The kernel uses AVX2 when the build enables it (ROCI_AVX2), SSE2 on any
+// other x86-64 build and plain scalar code elsewhere. Every path does the
+// same multiplies and adds in the same order, no fused multiply-add, so they
+// all give bit for bit the same results.
+//
+// Orientation is refreshed in the same pass while the chunk is hot, so the
+// collision pass straight after reads fresh unit vectors without any trig.
+
+// the kernel reads the components as packed floats
+static_assert(sizeof(Vec2) == 2 * sizeof(float) && std::is_standard_layout_v<Vec2>, "Vec2 must be two packed floats");
+static_assert(sizeof(Rotation) == 2 * sizeof(float) && std::is_standard_layout_v<Rotation>,
+              "Rotation must be two packed floats");
+
+// integrate count entities over dt, acc and rot may be nullptr:
+//   v += a * dt, p += v * dt, angle += angularVelocity * dt
+inline void integrateKinematics(std::size_t count, Position *pos, Velocity *vel, const Acceleration *acc,
+                                Rotation *rot, float dt) {
+  // x, y interleaved, the same operation on both so it's simply 2 * count floats
+  float *p = &pos->value.x;
+  float *v = &vel->value.x;
+  const float *a = acc ? &acc->value.x : nullptr;
+  std::size_t floats = 2 * count;
+  std::size_t i = 0;
+
+#if defined(__AVX2__)
+  const __m256 step = _mm256_set1_ps(dt);
+  for (; i + 8 <= floats; i += 8) {
+    __m256 vi = _mm256_loadu_ps(v + i);
+    if (a) {
+      vi = _mm256_add_ps(vi, _mm256_mul_ps(_mm256_loadu_ps(a + i), step));
+      _mm256_storeu_ps(v + i, vi);
+    }
+    _mm256_storeu_ps(p + i, _mm256_add_ps(_mm256_loadu_ps(p + i), _mm256_mul_ps(vi, step)));
+  }
+#elif defined(__SSE2__) || defined(_M_X64)
+  const __m128 step = _mm_set1_ps(dt);
+  for (; i + 4 <= floats; i += 4) {
+    __m128 vi = _mm_loadu_ps(v + i);
+    if (a) {
+      vi = _mm_add_ps(vi, _mm_mul_ps(_mm_loadu_ps(a + i), step));
+      _mm_storeu_ps(v + i, vi);
+    }
+    _mm_storeu_ps(p + i, _mm_add_ps(_mm_loadu_ps(p + i), _mm_mul_ps(vi, step)));
+  }
+#endif
+
+  // scalar fallback, and the tail that doesn't fill a whole vector
+  for (; i < floats; ++i) {
+    if (a) {
+      v[i] = v[i] + a[i] * dt;
+    }
+    p[i] = p[i] + v[i] * dt;
+  }
+
+  if (!rot)
+    return;
+
+  // angle, angularVelocity interleaved: shift angularVelocity * dt down one
+  // lane onto the angle and only keep the sum in the angle lanes
+  float *r = &rot->angle;
+  floats = 2 * count;
+  i = 0;
+
+#if defined(__AVX2__)
+  for (; i + 8 <= floats; i += 8) {
+    __m256 ri = _mm256_loadu_ps(r + i);
+    __m256 turn = _mm256_castsi256_ps(_mm256_srli_si256(_mm256_castps_si256(_mm256_mul_ps(ri, step)), 4));
+    _mm256_storeu_ps(r + i, _mm256_blend_ps(ri, _mm256_add_ps(ri, turn), 0x55));
+  }
+#elif defined(__SSE2__) || defined(_M_X64)
+  const __m128 angles = _mm_castsi128_ps(_mm_set_epi32(0, -1, 0, -1));
+  for (; i + 4 <= floats; i += 4) {
+    __m128 ri = _mm_loadu_ps(r + i);
+    __m128 turn = _mm_castsi128_ps(_mm_srli_si128(_mm_castps_si128(_mm_mul_ps(ri, step)), 4));
+    _mm_storeu_ps(r + i, _mm_or_ps(_mm_and_ps(angles, _mm_add_ps(ri, turn)), _mm_andnot_ps(angles, ri)));
+  }
+#endif
+
+  for (; i < floats; i += 2) {
+    r[i] = r[i] + r[i + 1] * dt;
+  }
+}
+
+// bring count cached orientations up to their rotations, the trig only for
+// the ones that turned
+inline void refreshOrientations(std::size_t count, const Rotation *rot, Orientation *orientation) {
+  for (std::size_t i = 0; i < count; ++i) {
+    if (orientation[i].angle != rot[i].angle) {
+      orientation[i].set(rot[i].angle);
+    }
+  }
+}
+
+// Integrate every entity with a Position and a Velocity, Acceleration and
+// Rotation are optional, and refresh the Orientation of the ones that have
+// one. Runs on the World's thread pool, the same rules as parallelEach()
+// apply: nothing else may touch these components meanwhile.
+template <typename World> void updateKinematics(World &ecs, float dt) {
+  if constexpr (World::CHUNKED) {
+    ecs.template parallelEachChunk<Position, Velocity, Optional<Acceleration>, Optional<Rotation>,
+                                   Optional<Orientation>>(
+        [dt](std::size_t count, const Entity *, Position *pos, Velocity *vel, Acceleration *acc, Rotation *rot,
+             Orientation *orientation) {
+          integrateKinematics(count, pos, vel, acc, rot, dt);
+          if (rot && orientation) {
+            refreshOrientations(count, rot, orientation);
+          }
+        });
+  }
+  else {
+    // the same sums as the kernel, so both storages move things identically
+    ecs.template parallelEach<Velocity, Acceleration>(
+        [dt](Entity, Velocity &vel, Acceleration &acc) { vel.value += acc.value * dt; });
+    ecs.template parallelEach<Position, Velocity>(
+        [dt](Entity, Position &pos, Velocity &vel) { pos.value += vel.value * dt; });
+    ecs.template parallelEach<Rotation>(
+        [dt](Entity, Rotation &rot) { rot.angle = rot.angle + rot.angularVelocity * dt; });
+    ecs.template parallelEach<Rotation, Orientation>(
+        [](Entity, Rotation &rot, Orientation &orientation) { refreshOrientations(1, &rot, &orientation); });
+  }
+}
@@ -1,11 +1,12 @@
 #pragma once
+#include "assets.hpp"
 #include "ecs.hpp"
 #include "ballistics.hpp"
 #include "components.hpp"
 #include "utils.hpp"
 #include <cmath>
-#include <SFML/Audio.hpp>
 #include <optional>
+#include <vector>
 
 #undef PDCTARGET_AI_DEBUG
 
@@ -26,17 +27,20 @@ static std::ostream pdcNullStream(&pdcNullBuffer); // global null stream to use
 
 #endif
 
-const Entity INVALID_TARGET_ID = 0xFFFF; // used to indicate no target
+const Entity INVALID_TARGET_ID = NULL_ENTITY; // used to indicate no target
 
 // to target the pdcs and burst fire at incoming torpedos or enemy ships
 class PdcTargeting {
 public:
   // Entity e is the player or enemy that is using the pdcs
-  PdcTargeting(Coordinator &ecs, Entity e, BulletFactory bulletFactory, sf::Sound pdcFireSoundPlayer) :
+  PdcTargeting(Coordinator &ecs, Entity e, BulletFactory bulletFactory, SoundEffect pdcFireSoundPlayer,
+               const IncomingTorpedoes &incoming) :
     ecs(ecs),
     e(e),
     bulletFactory(bulletFactory),
-    pdcFireSoundPlayer(pdcFireSoundPlayer)
+    incoming(incoming),
+    pdcFireSoundPlayer(pdcFireSoundPlayer),
+    pdc5Name(ecs.internName("PDC5"))
   {
     PDCTARGET_DEBUG << "PdcTarget created for entity: " << e << std::endl;
   }
@@ -49,14 +53,14 @@ public:
                   std::is_same_v<TargetType, FriendlyShipTarget>,
                   "TargetType must be EnemyShipTarget or FriendlyShipTarget");
 
-    Entity nearestShip = 0xFFFF;  // so as not to confuse with the player 
+    Entity nearestShip = INVALID_TARGET_ID;
     float nearestShipDist = std::numeric_limits<float>::max();
 
     shipTargetDistances.clear(); // clear the map of torpedo distances
 
     // find target ships
     // find the nearest for range, and add to the shipTargetDistances
-    for (auto &ship : ecs.view<TargetType>()) {
+    for (auto &ship : ecs.group<TargetType>()) {
 
       // find the nearest ship to the player or enemy
       auto &enemyPos = ecs.getComponent<Position>(ship);
@@ -76,7 +80,7 @@ public:
     }
 
     // no enemy ships to target
-    if (nearestShip == 0xFFFF) {
+    if (nearestShip == INVALID_TARGET_ID) {
       return;
     }
 
@@ -116,21 +120,14 @@ public:
 
   // target and fire upon incoming torpedos
   void pdcDefendTorpedo(float tt, float dt) {
-    Entity nearestTorpedo = 0xFFFF;  // so as not to confuse with the player
+    Entity nearestTorpedo = INVALID_TARGET_ID;
     float nearestTorpedoDist = std::numeric_limits<float>::max();
 
     torpedoTargetDistances.clear(); // clear the map of torpedo distances
 
     // find target torpedos
     // find the nearest for range, and add to the torpedoTargetDistances
-    for (auto &torpedo : ecs.view<TorpedoTarget>()) {
-      auto &torpedoTarget = ecs.getComponent<TorpedoTarget>(torpedo);
-
-      if (torpedoTarget.target != e) {
-        // skip if the torpedo is not targeting this entity
-        continue;
-      }
-
+    for (Entity torpedo : incoming.at(e)) {
       // find the nearest torpedo to the player or enemy
       auto &torpedoPos = ecs.getComponent<Position>(torpedo);
       auto &myPos = ecs.getComponent<Position>(e);
@@ -149,7 +146,7 @@ public:
     }
 
     // no torpedos to target
-    if (nearestTorpedo == 0xFFFF) {
+    if (nearestTorpedo == INVALID_TARGET_ID) {
       return;
     }
 
@@ -288,11 +285,15 @@ public:
 
     auto &mounts = ecs.getComponent<PdcMounts>(e);
 
+    // the ship's heading, for where each pdc sits on it
+    const Orientation orientation = currentOrientation(ecs, e);
+
     // aquire the targets for the PDCs
     for (Entity pdcEntity : mounts.pdcEntities) {
       auto &pdc = ecs.getComponent<Pdc>(pdcEntity);
 
-      if (pdc.target == INVALID_TARGET_ID) {
+      // no target, or the target has been destroyed since it was assigned
+      if (!ecs.valid(pdc.target)) {
         PDCTARGET_DEBUG << "PdcTarget no target for : " << ecs.getEntityName(pdcEntity) << "\n";
         continue; // no target assigned to this PDC
       }
@@ -305,10 +306,9 @@ public:
       auto &targetPos = ecs.getComponent<Position>(pdc.target); 
       auto &targetVel = ecs.getComponent<Velocity>(pdc.target);
       auto &entityPos = ecs.getComponent<Position>(e);
-      auto &entityRot = ecs.getComponent<Rotation>(e);
       auto &entityVel = ecs.getComponent<Velocity>(e);
 
-      sf::Vector2f pdcOffset = rotateVector({pdc.positionx, pdc.positiony}, entityRot.angle);
+      sf::Vector2f pdcOffset = orientation.rotate({pdc.positionx, pdc.positiony});
 
       // get the angle to the target, adjust for the position of the pdc
       float att = angleToTarget(entityPos.value + pdcOffset, targetPos.value);
@@ -367,6 +367,7 @@ public:
   void firePdcBursts(Entity source, float tt, float burstSpread)  {
 
     auto &mounts = ecs.getComponent<PdcMounts>(e);
+    firing.clear();
 
     // fire all the PDCs
     for (Entity pdcEntity : mounts.pdcEntities) {
@@ -382,7 +383,7 @@ public:
 
       // cycle the burst through +/- burstSpread,
       // introduce some randomness for one aft pdc.
-      if (ecs.getEntityName(pdcEntity) == "PDC5") {
+      if (ecs.getEntityNameId(pdcEntity) == pdc5Name) {
         pdc.burstSpreadAngle = burstSpread * std::cos(tt * 10.f); // oscillate between -burstSpread and +burstSpread
       }
       else {
@@ -402,7 +403,7 @@ public:
         << " burst spread angle: " << pdc.burstSpreadAngle << "\n";
 
       // check that we have a valid target and the target is within the firing angle of the PDCs
-      if (pdc.target != INVALID_TARGET_ID && isInRange(relativeFiringAngle, pdc.minFiringAngle, pdc.maxFiringAngle)) {
+      if (ecs.valid(pdc.target) && isInRange(relativeFiringAngle, pdc.minFiringAngle, pdc.maxFiringAngle)) {
 
         if (pdc.timeSinceBurst == 0 || tt > pdc.timeSinceBurst + pdc.pdcBurstCooldown) {
           pdc.timeSinceBurst = tt;
@@ -412,7 +413,7 @@ public:
         if (pdc.pdcBurst > 0 && pdc.rounds) {
           if (tt > pdc.timeSinceFired + pdc.cooldown) {
             pdc.timeSinceFired = tt;
-            bulletFactory.fireone(source, pdcEntity, tt);
+            firing.push_back(pdcEntity);
             pdc.rounds--;
             pdc.pdcBurst--;
             pdcFireSoundPlayer.play();
@@ -432,6 +433,11 @@ public:
         pdc.firingAngle = pdc.minFiringAngle;
       }
     }
+
+    // every pdc that fired this frame in one batch
+    if (!firing.empty()) {
+      bulletFactory.fire(source, firing.data(), firing.size(), tt);
+    }
   }
 
 
@@ -439,7 +445,10 @@ private:
   Coordinator &ecs;
   Entity e;        // player or enemy that is using the pdcs
   BulletFactory bulletFactory;
-  sf::Sound pdcFireSoundPlayer;
+  const IncomingTorpedoes &incoming; // torpedoes targeting e
+  SoundEffect pdcFireSoundPlayer;
+  NameId pdc5Name;  // the aft pdc gets a different burst spread
+  std::vector<Entity> firing; // pdcs firing this frame, kept to reuse its capacity
  
   std::map<float, Entity> torpedoTargetDistances;      // map of torpedo targets and their distances
   std::map<float, Entity> shipTargetDistances;         // map of ships and their distances
@@ -0,0 +1,44 @@
+#pragma once
+#include <cstdint>
+
+///////////////////////////////////////////////////////////////////////////////
+// PLAYER INPUT
+///////////////////////////////////////////////////////////////////////////////
+// Everything the player does in one sim step. The game samples the keyboard
+// and mouse into one of these per step, roci-sim makes them up (autopilot)
+// or reads them back from a replay log, and the sim only ever sees this, so
+// the same inputs give the same game.
+//
+// The held buttons are what's down during the step. The one-shot ones come
+// from key releases and are set for just the step after the release.
+struct PlayerInput {
+  enum Button : std::uint16_t {
+    ROTATE_LEFT = 1u << 0,     // H
+    ROTATE_RIGHT = 1u << 1,    // L
+    BURN = 1u << 2,            // left mouse, turn and burn towards aim
+    STRAFE = 1u << 3,          // right mouse, strafe towards aim
+    FLIP_AND_STOP = 1u << 4,   // S
+    ATTACK_PDC = 1u << 5,      // E
+    DEFENCE_PDC = 1u << 6,     // D
+    FIRE_TORPEDOES = 1u << 7,  // Space
+
+    // one-shot
+    NEXT_TARGET = 1u << 8,      // T
+    ASSIGN_LAUNCHER1 = 1u << 9, // 1
+    ASSIGN_LAUNCHER2 = 1u << 10, // 2
+    MORE_ACCEL = 1u << 11,      // K, constant acceleration +1G
+    LESS_ACCEL = 1u << 12,      // J, constant acceleration -1G
+  };
+
+  std::uint16_t buttons = 0;
+
+  // the mouse relative to the centre of the screen (where the player is
+  // drawn), in pixels
+  std::int16_t aimX = 0;
+  std::int16_t aimY = 0;
+
+  bool pressed(Button b) const { return (buttons & b) != 0; }
+
+  bool operator==(const PlayerInput &o) const { return buttons == o.buttons && aimX == o.aimX && aimY == o.aimY; }
+  bool operator!=(const PlayerInput &o) const { return !(*this == o); }
+};
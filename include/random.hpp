@@ -0,0 +1,53 @@
+#pragma once
+#include <cassert>
+#include <cstdint>
+
+///////////////////////////////////////////////////////////////////////////////
+// RANDOM NUMBERS
+///////////////////////////////////////////////////////////////////////////////
+// A seeded PCG32 generator. The sim never uses rand(): anything random draws
+// from its own Rng, and every Rng comes from the Simulation's seed plus a
+// stream id, so a seed gives the same game every time and one subsystem
+// drawing more numbers doesn't shift what another one gets. The same seed
+// and input log replay bit for bit (see replay.hpp).
+//
+// The stream ids are fixed, add new ones at the end.
+enum class RngStream : std::uint64_t {
+  ASTEROIDS = 1,
+};
+
+class Rng {
+public:
+  Rng(std::uint64_t seed, RngStream stream) : increment((static_cast<std::uint64_t>(stream) << 1u) | 1u) {
+    next();
+    state += seed;
+    next();
+  }
+
+  // 32 random bits
+  std::uint32_t next() {
+    std::uint64_t old = state;
+    state = old * 6364136223846793005ULL + increment;
+    std::uint32_t xorshifted = static_cast<std::uint32_t>(((old >> 18u) ^ old) >> 27u);
+    std::uint32_t rot = static_cast<std::uint32_t>(old >> 59u);
+    return (xorshifted >> rot) | (xorshifted << ((32u - rot) & 31u));
+  }
+
+  // min to max, either way round (same as the old randFloat)
+  float uniform(float min, float max) {
+    // 24 bits, exactly representable as a float in [0, 1)
+    float unit = static_cast<float>(next() >> 8) * (1.f / 16777216.f);
+    return min + unit * (max - min);
+  }
+
+  // min to max inclusive
+  int range(int min, int max) {
+    assert(min <= max && "Rng::range min is more than max");
+    std::uint32_t span = static_cast<std::uint32_t>(max - min) + 1u;
+    return min + static_cast<int>(next() % span);
+  }
+
+private:
+  std::uint64_t state = 0;
+  std::uint64_t increment;
+};
@@ -0,0 +1,186 @@
+#pragma once
+#include "components.hpp"
+#include "ecs.hpp"
+#include "playerinput.hpp"
+#include <algorithm>
+#include <cstdint>
+#include <cstring>
+#include <fstream>
+#include <iterator>
+#include <string>
+#include <vector>
+
+///////////////////////////////////////////////////////////////////////////////
+// REPLAY
+///////////////////////////////////////////////////////////////////////////////
+// A recorded game: the seed, the scenario, the step size, the player's input
+// for every step and a hash of the world after every step. The sim is deterministic
+// given those (seeded Rng streams, fixed dt, input only through
+// PlayerInput), so roci-sim --replay runs the exact same game and checks its
+// hash every step. A mismatch means something non-deterministic got in, the
+// first bad step says where.
+//
+// The input is run length encoded, held buttons and a still mouse make long
+// runs. Replays need the same build: a different compiler or flags (AVX2,
+// the storage backend) can round the floats differently.
+
+// FNV-1a over the bits of the world's state
+class StateHash {
+public:
+  void add(std::uint64_t v) {
+    for (int i = 0; i < 8; ++i) {
+      hash = (hash ^ ((v >> (8 * i)) & 0xffu)) * 0x100000001b3ULL;
+    }
+  }
+
+  void add(float f) {
+    std::uint32_t bits;
+    std::memcpy(&bits, &f, sizeof(bits));
+    add(static_cast<std::uint64_t>(bits));
+  }
+
+  void add(sf::Vector2f v) {
+    add(v.x);
+    add(v.y);
+  }
+
+  std::uint64_t value() const { return hash; }
+
+private:
+  std::uint64_t hash = 0xcbf29ce484222325ULL;
+};
+
+// everything that moves or can be hurt: the handles, positions, velocities,
+// rotations and health, in the World's iteration order (which the same
+// sequence of creates and destroys always reproduces)
+inline std::uint64_t hashWorld(Coordinator &ecs, float tt) {
+  StateHash h;
+  h.add(tt);
+  for (auto [e, pos, vel, rot, health] :
+       ecs.range<Position, Optional<Velocity>, Optional<Rotation>, Optional<Health>>()) {
+    h.add(static_cast<std::uint64_t>(e));
+    h.add(pos.value);
+    if (vel)
+      h.add(vel->value);
+    if (rot) {
+      h.add(rot->angle);
+      h.add(rot->angularVelocity);
+    }
+    if (health)
+      h.add(static_cast<std::uint64_t>(static_cast<std::uint32_t>(health->value)));
+  }
+  return h.value();
+}
+
+class ReplayLog {
+public:
+  ReplayLog() = default;
+  ReplayLog(std::uint64_t seed, float dt, std::uint8_t scenario = 0) : seed(seed), dt(dt), scenario(scenario) {}
+
+  std::uint64_t seed = 0;
+  float dt = 0.f;
+  std::uint8_t scenario = 0; // a Scenario, 0 is the game's
+
+  // after each step: the input it ran with and the world's hash after it
+  void record(const PlayerInput &input, std::uint64_t hash) {
+    if (runs.empty() || runs.back().input != input) {
+      runs.push_back({static_cast<std::uint32_t>(hashes.size()), input});
+    }
+    hashes.push_back(hash);
+  }
+
+  std::size_t ticks() const { return hashes.size(); }
+
+  // the input for step tick (0 based)
+  PlayerInput input(std::size_t tick) const {
+    auto run = std::upper_bound(runs.begin(), runs.end(), tick,
+                                [](std::size_t t, const Run &r) { return t < r.start; });
+    return run == runs.begin() ? PlayerInput{} : std::prev(run)->input;
+  }
+
+  std::uint64_t hash(std::size_t tick) const { return hashes[tick]; }
+
+  std::size_t inputRuns() const { return runs.size(); }
+
+  ///////////////////////////////////////////////////////////////////////////////
+  // File format, native byte order:
+  //   "ROCIRPL2"  u64 seed  f32 dt  u8 scenario  u32 ticks  u32 runs
+  //   runs x  { u32 start tick, u16 buttons, i16 aimX, i16 aimY }
+  //   ticks x { u64 hash }
+  // "ROCIRPL1" files, from before the scenarios, have no scenario byte.
+  ///////////////////////////////////////////////////////////////////////////////
+  bool save(const std::string &path) const {
+    std::ofstream out(path, std::ios::binary);
+    if (!out)
+      return false;
+
+    out.write(MAGIC, sizeof(MAGIC));
+    write(out, seed);
+    write(out, dt);
+    write(out, scenario);
+    write(out, static_cast<std::uint32_t>(hashes.size()));
+    write(out, static_cast<std::uint32_t>(runs.size()));
+    for (const Run &run : runs) {
+      write(out, run.start);
+      write(out, run.input.buttons);
+      write(out, run.input.aimX);
+      write(out, run.input.aimY);
+    }
+    for (std::uint64_t hash : hashes) {
+      write(out, hash);
+    }
+    return static_cast<bool>(out);
+  }
+
+  bool load(const std::string &path) {
+    std::ifstream in(path, std::ios::binary);
+    char magic[sizeof(MAGIC)];
+    if (!in.read(magic, sizeof(magic)))
+      return false;
+
+    bool version1 = std::memcmp(magic, MAGIC_V1, sizeof(MAGIC_V1)) == 0;
+    if (!version1 && std::memcmp(magic, MAGIC, sizeof(MAGIC)) != 0)
+      return false;
+
+    std::uint32_t tickCount = 0, runCount = 0;
+    read(in, seed);
+    read(in, dt);
+    scenario = 0;
+    if (!version1) {
+      read(in, scenario);
+    }
+    read(in, tickCount);
+    read(in, runCount);
+
+    runs.resize(runCount);
+    for (Run &run : runs) {
+      read(in, run.start);
+      read(in, run.input.buttons);
+      read(in, run.input.aimX);
+      read(in, run.input.aimY);
+    }
+    hashes.resize(tickCount);
+    for (std::uint64_t &hash : hashes) {
+      read(in, hash);
+    }
+    return static_cast<bool>(in);
+  }
+
+private:
+  static constexpr char MAGIC[8] = {'R', 'O', 'C', 'I', 'R', 'P', 'L', '2'};
+  static constexpr char MAGIC_V1[8] = {'R', 'O', 'C', 'I', 'R', 'P', 'L', '1'};
+
+  struct Run {
+    std::uint32_t start; // first tick with this input
+    PlayerInput input;
+  };
+
+  std::vector<Run> runs;
+  std::vector<std::uint64_t> hashes; // one per tick
+
+  template <typename T> static void write(std::ofstream &out, const T &v) {
+    out.write(reinterpret_cast<const char *>(&v), sizeof(T));
+  }
+
+  template <typename T> static void read(std::ifstream &in, T &v) { in.read(reinterpret_cast<char *>(&v), sizeof(T)); }
+};
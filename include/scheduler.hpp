@@ -0,0 +1,169 @@
+#pragma once
+#include "ecs.hpp"
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <functional>
+#include <string>
+#include <utility>
+#include <vector>
+
+///////////////////////////////////////////////////////////////////////////////
+// SYSTEM SCHEDULER
+///////////////////////////////////////////////////////////////////////////////
+// Runs the frame's systems as a dependency graph instead of a fixed chain.
+// Every system declares the components it reads and writes, any shared
+// non-ECS state it uses (explosions list, ...) as a resource bit, or that it
+// is exclusive. Two systems conflict if one writes something the other
+// touches, they share a resource, or either is exclusive. A system depends
+// on every earlier added system it conflicts with, so conflicting systems
+// keep the order they were added in and the rest run side by side on the
+// World's thread pool.
+//
+// Exclusive is for anything that can't share the World: structural changes
+// (creating/destroying entities, adding/removing components, commands() and
+// flush()), or work that has to stay on the main thread like input. An
+// exclusive system always runs on its own, on the thread that calls run().
+//
+// The first run() is serial so the groups the systems query are registered
+// before anything runs concurrently.
+template <typename World> class Scheduler {
+public:
+  // what a system touches, e.g.
+  //   Access().reads<Position>().writes<Acceleration>().uses(EXPLOSIONS)
+  class Access {
+  public:
+    template <typename... Comps> Access &reads() {
+      readSet |= World::template componentMask<Comps...>();
+      return *this;
+    }
+
+    template <typename... Comps> Access &writes() {
+      writeSet |= World::template componentMask<Comps...>();
+      return *this;
+    }
+
+    // resource is a bit index (0-31) picked by the caller
+    Access &uses(unsigned resource) {
+      resources |= 1u << resource;
+      return *this;
+    }
+
+    Access &exclusive() {
+      isExclusive = true;
+      return *this;
+    }
+
+    bool conflictsWith(const Access &other) const {
+      return isExclusive || other.isExclusive || (resources & other.resources) ||
+             (writeSet & (other.readSet | other.writeSet)).any() || (other.writeSet & readSet).any();
+    }
+
+  private:
+    Signature readSet, writeSet;
+    std::uint32_t resources = 0;
+    bool isExclusive = false;
+  };
+
+  struct Timing {
+    std::string name;
+    float lastMs = 0.f;    // the last run
+    float averageMs = 0.f; // smoothed over roughly the last second at 60Hz
+  };
+
+  explicit Scheduler(World &world) : world(world) {}
+
+  // systems run in the order they're added wherever they conflict
+  void add(std::string name, Access access, std::function<void()> update) {
+    systems.push_back({std::move(access), std::move(update)});
+    stats.push_back({std::move(name)});
+    built = false;
+  }
+
+  // run every system once, in dependency order
+  void run() {
+    if (!built) {
+      build();
+    }
+
+    for (std::size_t level = 0; level + 1 < levelStart.size(); ++level) {
+      std::size_t begin = levelStart[level], end = levelStart[level + 1];
+
+      if (end - begin == 1 || firstRun) {
+        for (std::size_t i = begin; i < end; ++i) {
+          runSystem(order[i]);
+        }
+      }
+      else {
+        world.threads().parallelFor(end - begin, 1, [&](std::size_t first, std::size_t last) {
+          for (std::size_t i = first; i < last; ++i) {
+            runSystem(order[begin + i]);
+          }
+        });
+      }
+    }
+
+    firstRun = false;
+  }
+
+  // per system timings, in the order the systems were added
+  const std::vector<Timing> &timings() const { return stats; }
+
+private:
+  struct System {
+    Access access;
+    std::function<void()> update;
+  };
+
+  World &world;
+  std::vector<System> systems;
+  std::vector<Timing> stats;
+
+  // systems grouped by level, a system only depends on ones in lower levels
+  // so each level can run in parallel. order[levelStart[l], levelStart[l+1])
+  // is level l.
+  std::vector<std::size_t> order;
+  std::vector<std::size_t> levelStart;
+  bool built = false;
+  bool firstRun = true;
+
+  void build() {
+    std::vector<std::size_t> level(systems.size(), 0);
+    std::size_t levels = 0;
+
+    // an edge from every earlier conflicting system, its level is one past
+    // the deepest of those
+    for (std::size_t j = 0; j < systems.size(); ++j) {
+      for (std::size_t i = 0; i < j; ++i) {
+        if (systems[i].access.conflictsWith(systems[j].access)) {
+          level[j] = std::max(level[j], level[i] + 1);
+        }
+      }
+      levels = std::max(levels, level[j] + 1);
+    }
+
+    order.clear();
+    levelStart.clear();
+    for (std::size_t l = 0; l < levels; ++l) {
+      levelStart.push_back(order.size());
+      for (std::size_t j = 0; j < systems.size(); ++j) {
+        if (level[j] == l) {
+          order.push_back(j);
+        }
+      }
+    }
+    levelStart.push_back(order.size());
+
+    built = true;
+  }
+
+  void runSystem(std::size_t i) {
+    auto start = std::chrono::steady_clock::now();
+    systems[i].update();
+    float ms = std::chrono::duration<float, std::milli>(std::chrono::steady_clock::now() - start).count();
+
+    Timing &timing = stats[i];
+    timing.lastMs = ms;
+    timing.averageMs += (ms - timing.averageMs) / 60.f;
+  }
+};
@@ -0,0 +1,88 @@
+#pragma once
+
+#include "assets.hpp"
+#include "asteroids.hpp"
+#include "ballistics.hpp"
+#include "collision.hpp"
+#include "damage.hpp"
+#include "ecs.hpp"
+#include "enemyai.hpp"
+#include "explosion.hpp"
+#include "pdctarget.hpp"
+#include "playerinput.hpp"
+#include "scheduler.hpp"
+#include "torpedoai.hpp"
+#include "torpedotarget.hpp"
+#include "utils.hpp"
+#include <cstdint>
+#include <thread>
+#include <vector>
+
+///////////////////////////////////////////////////////////////////////////////
+// SIMULATION
+///////////////////////////////////////////////////////////////////////////////
+// The game world without the window: the ships, asteroids, factories, AIs
+// and the scheduled systems, stepped dt at a time. The game draws it and
+// feeds it input, roci-sim runs it headless as fast as it can.
+//
+// Everything random comes from the seed and the player only acts through
+// the PlayerInput passed to step(), so the same seed and inputs always play
+// the same game (see replay.hpp).
+
+// Where the fight starts. PATROL is the game: the enemies start about 280 km
+// out and take minutes to close in. ENGAGEMENT starts them ten times closer,
+// inside torpedo and PDC range, so a short run gets to the hits, damage,
+// debris and destroyed ships straight away (e.g. to check a replay of them).
+enum class Scenario : std::uint8_t { PATROL, ENGAGEMENT };
+
+class Simulation {
+public:
+  // threads sizes the ECS thread pool, the result is the same for any count
+  Simulation(Assets &assets, float dt, std::uint64_t seed, Scenario scenario = Scenario::PATROL,
+             unsigned threads = std::thread::hardware_concurrency());
+
+  Simulation(const Simulation &) = delete; // the systems point back at it
+  Simulation &operator=(const Simulation &) = delete;
+
+  // one fixed step of every system, with the player doing input
+  void step(const PlayerInput &input);
+
+  const float dt;
+  const std::uint64_t seed;
+  const Scenario scenario;
+  float tt = 0; // total time for weapon cooldown
+
+  Coordinator ecs;
+  std::vector<Explosion> explosions;
+
+  Entity player;
+  Entity enemy1, enemy2, enemy3;
+
+  BulletFactory bulletFactory;
+  TorpedoFactory torpedoFactory;
+
+  // which torpedoes are heading for which ship
+  IncomingTorpedoes incomingTorpedoes;
+
+  EnemyAI enemy1AI, enemy2AI, enemy3AI;
+  TorpedoAI torpedoAI;
+
+  // the player's weapons
+  PdcTargeting pdcTargeting;
+  TorpedoTargeting torpedoTargeting;
+
+  AsteroidFactory asteroidFactory;
+  CollisionSystem collisionSystem;
+  DamageSystem damageSystem;
+
+  Scheduler<Coordinator> scheduler;
+
+  // constant acceleration while no other burn is on, K/J change it
+  float constAccelGs = 0.f;
+
+private:
+  PlayerInput input; // for the step that's running
+
+  void addSystems();
+  void controlPlayer(const PlayerInput &input);
+};
@@ -0,0 +1,141 @@
+#pragma once
+#include <SFML/System/Vector2.hpp>
+#include <algorithm>
+#include <cassert>
+#include <cmath>
+#include <cstdint>
+#include <vector>
+
+///////////////////////////////////////////////////////////////////////////////
+// SPATIAL HASH
+///////////////////////////////////////////////////////////////////////////////
+// A uniform grid broadphase over an unbounded world. Every item goes into
+// each cell its bounding box touches, and two items are candidates only if
+// they share a cell. Items are numbered by the caller, 0 to n-1 (e.g. the
+// index in a group).
+//
+// It is rebuilt every tick: clear(), insert() everything, build(). The cells
+// are a sorted list of (cell, item) entries instead of a hash map, so a
+// rebuild is one sort and allocates nothing once the vectors have grown.
+//
+// The candidates can be had an item at a time (candidates()) or a cell at a
+// time (eachPairInCell()). The cells are independent of each other, so they
+// can be handed out to threads.
+//
+// Cell size: a box only spans a few cells if the cells are about as big as
+// the biggest common box. The game's boxes run from PDC rounds (140 across)
+// to the big asteroids (about 3500 across), 2048 puts a round in 1-4 cells
+// and the biggest asteroid in at most 9.
+class SpatialHash {
+public:
+  explicit SpatialHash(float cellSize = 2048.f) : inverseCellSize(1.f / cellSize) {
+    assert(cellSize > 0.f && "SpatialHash cell size must be positive");
+  }
+
+  void clear() {
+    entries.clear();
+    spans.clear();
+    cellStarts.clear();
+  }
+
+  // item must be the number of items inserted so far
+  void insert(std::uint32_t item, sf::Vector2f min, sf::Vector2f max) {
+    assert(item == spans.size() && "SpatialHash items must be inserted in order");
+    Span span{cell(min.x), cell(min.y), cell(max.x), cell(max.y)};
+    spans.push_back(span);
+
+    for (std::int32_t y = span.minY; y <= span.maxY; ++y) {
+      for (std::int32_t x = span.minX; x <= span.maxX; ++x) {
+        entries.push_back({key(x, y), item});
+      }
+    }
+  }
+
+  // after the inserts, before candidates()
+  void build() {
+    std::sort(entries.begin(), entries.end(), [](const Entry &a, const Entry &b) {
+      return a.cell != b.cell ? a.cell < b.cell : a.item < b.item;
+    });
+
+    // where each occupied cell's run of entries starts, and the end
+    cellStarts.clear();
+    for (std::uint32_t i = 0; i < entries.size(); ++i) {
+      if (i == 0 || entries[i].cell != entries[i - 1].cell) {
+        cellStarts.push_back(i);
+      }
+    }
+    cellStarts.push_back(static_cast<std::uint32_t>(entries.size()));
+  }
+
+  // occupied cells after build(), numbered 0 to cells() - 1
+  std::size_t cells() const { return cellStarts.empty() ? 0 : cellStarts.size() - 1; }
+
+  // fn(a, b) with a < b for the pairs of items in cell c, in ascending
+  // order. Two items can share more than one cell, a pair is only handed
+  // out by the first of them (the top left of where their boxes overlap),
+  // so over all the cells each pair comes up exactly once.
+  template <typename Fn> void eachPairInCell(std::size_t c, Fn &&fn) const {
+    std::uint32_t begin = cellStarts[c], end = cellStarts[c + 1];
+    std::uint64_t k = entries[begin].cell;
+
+    for (std::uint32_t i = begin; i < end; ++i) {
+      const Span &a = spans[entries[i].item];
+      for (std::uint32_t j = i + 1; j < end; ++j) {
+        const Span &b = spans[entries[j].item];
+        if (key(std::max(a.minX, b.minX), std::max(a.minY, b.minY)) == k) {
+          fn(entries[i].item, entries[j].item);
+        }
+      }
+    }
+  }
+
+  // the items sharing a cell with item, each once, in ascending order and
+  // without item itself
+  void candidates(std::uint32_t item, std::vector<std::uint32_t> &out) const {
+    out.clear();
+    const Span &span = spans[item];
+
+    for (std::int32_t y = span.minY; y <= span.maxY; ++y) {
+      for (std::int32_t x = span.minX; x <= span.maxX; ++x) {
+        std::uint64_t k = key(x, y);
+        auto it = std::lower_bound(entries.begin(), entries.end(), k,
+                                   [](const Entry &e, std::uint64_t k) { return e.cell < k; });
+        for (; it != entries.end() && it->cell == k; ++it) {
+          if (it->item != item) {
+            out.push_back(it->item);
+          }
+        }
+      }
+    }
+
+    // an item in more than one shared cell shows up more than once
+    if (span.minX != span.maxX || span.minY != span.maxY) {
+      std::sort(out.begin(), out.end());
+      out.erase(std::unique(out.begin(), out.end()), out.end());
+    }
+  }
+
+  std::size_t items() const { return spans.size(); }
+  std::size_t cellEntries() const { return entries.size(); }
+
+private:
+  struct Entry {
+    std::uint64_t cell;
+    std::uint32_t item;
+  };
+
+  struct Span {
+    std::int32_t minX, minY, maxX, maxY;
+  };
+
+  float inverseCellSize;
+  std::vector<Entry> entries; // sorted by cell after build()
+  std::vector<Span> spans;    // by item
+  std::vector<std::uint32_t> cellStarts; // into entries, by cell, then the end
+
+  std::int32_t cell(float v) const { return static_cast<std::int32_t>(std::floor(v * inverseCellSize)); }
+
+  static std::uint64_t key(std::int32_t x, std::int32_t y) {
+    return (static_cast<std::uint64_t>(static_cast<std::uint32_t>(x)) << 32) | static_cast<std::uint32_t>(y);
+  }
+};
@@ -0,0 +1,216 @@
+#pragma once
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <type_traits>
+#include <vector>
+
+///////////////////////////////////////////////////////////////////////////////
+// THREAD POOL
+///////////////////////////////////////////////////////////////////////////////
+// A small work-stealing pool for data parallel loops. parallelFor() cuts a
+// range into chunks and deals them out round robin to one queue per worker,
+// the calling thread is worker 0 and helps until the loop is done. A worker
+// takes from the back of its own queue and, when that's empty, steals from
+// the front of the others, so uneven chunks still balance out.
+//
+// The chunks only depend on the range size and the worker count, never on
+// timing, so a loop whose body only writes to its own index gives the same
+// result whichever thread ran which chunk. For scratch data index an array by
+// currentWorker(), and merge it in a fixed order afterwards.
+//
+// Loops can nest: a task that calls parallelFor() (e.g. a parallelEach() in
+// a system the scheduler runs next to others) queues its chunks like any
+// other loop, so they spread over the idle workers too. While it waits the
+// task's thread runs other queued tasks, so a task mustn't keep its
+// currentWorker() scratch in use across a nested loop.
+class ThreadPool {
+public:
+  explicit ThreadPool(unsigned threads = std::thread::hardware_concurrency()) {
+    threads = std::max(threads, 1u);
+
+    for (unsigned i = 0; i < threads; ++i) {
+      queues.push_back(std::make_unique<Queue>());
+    }
+
+    // worker 0 is whoever calls parallelFor()
+    for (unsigned i = 1; i < threads; ++i) {
+      workers.emplace_back([this, i] { workerLoop(i); });
+    }
+  }
+
+  ~ThreadPool() {
+    {
+      std::lock_guard<std::mutex> lock(sleepMutex);
+      stopping = true;
+    }
+    wake.notify_all();
+
+    for (auto &worker : workers) {
+      worker.join();
+    }
+  }
+
+  ThreadPool(const ThreadPool &) = delete;
+  ThreadPool &operator=(const ThreadPool &) = delete;
+
+  // number of workers, including the calling thread
+  unsigned size() const { return static_cast<unsigned>(queues.size()); }
+
+  // the worker running the current task, 0 on the calling thread. Use it to
+  // index per thread scratch arrays of the size() of the pool running the
+  // task, a task of one pool may call another pool's parallelFor().
+  static unsigned currentWorker() { return workerIndex; }
+
+  // run fn(begin, end) over [0, count) in chunks of about grain indices and
+  // wait for all of them, a range of grain or less just runs inline
+  template <typename Fn> void parallelFor(std::size_t count, std::size_t grain, Fn &&fn) {
+    grain = std::max<std::size_t>(grain, 1);
+
+    // a worker of another pool (or any other thread) is our worker 0
+    const unsigned me = workerPool == this ? workerIndex : 0;
+
+    if (size() == 1 || count <= grain) {
+      if (count > 0) {
+        WorkerScope scope(this, me);
+        fn(std::size_t(0), count);
+      }
+      return;
+    }
+
+    // this loop's chunks that haven't finished, on the stack so loops on
+    // different threads (nested ones) each wait for their own
+    std::size_t chunks = (count + grain - 1) / grain;
+    std::atomic<std::size_t> pending{chunks};
+
+    // count them first so a worker that takes one early never sees queued < 0
+    {
+      std::lock_guard<std::mutex> lock(sleepMutex);
+      queued.fetch_add(chunks);
+    }
+
+    // dealt out starting with our own queue, the first chunks stay here
+    for (std::size_t c = 0; c < chunks; ++c) {
+      Task task{&invoke<std::remove_reference_t<Fn>>, &fn, c * grain, std::min(count, (c + 1) * grain), &pending};
+      Queue &queue = *queues[(me + c) % size()];
+      std::lock_guard<std::mutex> lock(queue.mutex);
+      queue.tasks.push_back(task);
+    }
+    wake.notify_all();
+
+    // help out, then wait for the chunks other workers are still running
+    while (pending.load() > 0) {
+      if (!runOne(me)) {
+        std::this_thread::yield();
+      }
+    }
+  }
+
+private:
+  struct Task {
+    void (*run)(void *fn, std::size_t begin, std::size_t end);
+    void *fn;
+    std::size_t begin, end;
+    std::atomic<std::size_t> *pending; // the loop's count to tick off
+  };
+
+  // tasks[head, size) are waiting, the vector keeps its capacity so queueing
+  // doesn't allocate once the pool has warmed up
+  struct Queue {
+    std::mutex mutex;
+    std::vector<Task> tasks;
+    std::size_t head = 0;
+  };
+
+  std::vector<std::unique_ptr<Queue>> queues;
+  std::vector<std::thread> workers;
+
+  std::atomic<std::size_t> queued{0}; // tasks in the queues
+  std::mutex sleepMutex;
+  std::condition_variable wake;
+  bool stopping = false;
+
+  // the pool whose task this thread is running and its worker number there,
+  // nullptr and 0 outside of any task on a thread that isn't a worker
+  static inline thread_local const ThreadPool *workerPool = nullptr;
+  static inline thread_local unsigned workerIndex = 0;
+
+  // this thread is worker me of runner while the scope lasts
+  struct WorkerScope {
+    const ThreadPool *pool;
+    unsigned index;
+
+    WorkerScope(const ThreadPool *runner, unsigned me) : pool(workerPool), index(workerIndex) {
+      workerPool = runner;
+      workerIndex = me;
+    }
+    ~WorkerScope() {
+      workerPool = pool;
+      workerIndex = index;
+    }
+  };
+
+  template <typename Fn> static void invoke(void *fn, std::size_t begin, std::size_t end) {
+    (*static_cast<Fn *>(fn))(begin, end);
+  }
+
+  bool take(Queue &queue, bool own, Task &task) {
+    std::lock_guard<std::mutex> lock(queue.mutex);
+    if (queue.head == queue.tasks.size())
+      return false;
+
+    if (own) {
+      task = queue.tasks.back();
+      queue.tasks.pop_back();
+    }
+    else {
+      task = queue.tasks[queue.head++];
+    }
+
+    if (queue.head == queue.tasks.size()) {
+      queue.tasks.clear();
+      queue.head = 0;
+    }
+    return true;
+  }
+
+  // run one task from our own queue, or steal one, false if there was none
+  bool runOne(unsigned me) {
+    Task task;
+    bool found = take(*queues[me], true, task);
+
+    for (unsigned i = 1; !found && i < size(); ++i) {
+      found = take(*queues[(me + i) % size()], false, task);
+    }
+
+    if (!found)
+      return false;
+
+    queued.fetch_sub(1);
+    {
+      WorkerScope scope(this, me);
+      task.run(task.fn, task.begin, task.end);
+    }
+    task.pending->fetch_sub(1); // the loop may return as soon as this hits 0
+    return true;
+  }
+
+  void workerLoop(unsigned me) {
+    workerPool = this;
+    workerIndex = me;
+
+    for (;;) {
+      if (runOne(me))
+        continue;
+
+      std::unique_lock<std::mutex> lock(sleepMutex);
+      wake.wait(lock, [this] { return stopping || queued.load() > 0; });
+      if (stopping)
+        return;
+    }
+  }
+};
@@ -0,0 +1,162 @@
+#pragma once
+#include "components.hpp"
+#include "ecs.hpp"
+#include "utils.hpp"
+#include <algorithm>
+#include <cstddef>
+#include <vector>
+
+///////////////////////////////////////////////////////////////////////////////
+// FIXED TIMESTEP
+///////////////////////////////////////////////////////////////////////////////
+// Runs the simulation at a fixed rate whatever the frame rate is. Every frame
+// the real elapsed time goes into an accumulator and the sim runs as many
+// whole steps as it holds, so a frame hitch means a few extra steps instead
+// of one big dt that changes trajectories or lets fast rounds tunnel through
+// torpedoes. What's left over is alpha(), how far the render is between the
+// last two sim states.
+//
+// If the sim can't keep up it gives up after maxSteps per frame and drops
+// the rest of the backlog, so the game slows down instead of spiralling.
+class FixedTimestep {
+public:
+  explicit FixedTimestep(float hz = 120.f, unsigned maxSteps = 8) { setRate(hz, maxSteps); }
+
+  void setRate(float hz, unsigned maxSteps) {
+    dt = 1.f / std::max(hz, 1.f);
+    this->maxSteps = std::max(maxSteps, 1u);
+  }
+
+  // seconds per step
+  float step() const { return dt; }
+
+  // add a frame's elapsed time, returns how many steps to run for it
+  unsigned advance(float frameSeconds) { return advance(frameSeconds, maxSteps); }
+
+  // the same with a different cap for this frame (time warp)
+  unsigned advance(float frameSeconds, unsigned maxSteps) {
+    accumulator += frameSeconds;
+
+    unsigned steps = static_cast<unsigned>(accumulator / dt);
+    if (steps > maxSteps) {
+      steps = maxSteps;
+      accumulator = 0.0;
+    }
+    else {
+      accumulator -= steps * static_cast<double>(dt);
+    }
+    return steps;
+  }
+
+  // 0-1, the part of a step the accumulator holds after advance()
+  float alpha() const { return static_cast<float>(accumulator / dt); }
+
+private:
+  float dt = 1.f / 120.f;
+  unsigned maxSteps = 8;
+  double accumulator = 0.0; // double so tiny frame times don't get lost
+};
+
+///////////////////////////////////////////////////////////////////////////////
+// TIME WARP
+///////////////////////////////////////////////////////////////////////////////
+// Time compression for the long transits: the frame time going into the
+// FixedTimestep is multiplied by the warp factor, so a frame runs more of the
+// same fixed steps and the trajectories are the same as at 1x. The steps per
+// frame are capped by a time budget, using the measured cost of a step, so
+// the frame rate holds. If the sim can't keep up at that budget the real
+// warp is just lower, effective() says what it actually managed.
+//
+// The game drops the warp back to 1x when anything comes into threat range.
+class TimeWarp {
+public:
+  explicit TimeWarp(double budgetMs = 10.0) : budgetMs(budgetMs) {}
+
+  void faster() { level = std::min(level + 1, LEVELS - 1); }
+  void slower() { level = level > 0 ? level - 1 : 0; }
+  void stop() { level = 0; }
+
+  float factor() const { return FACTORS[level]; }
+  bool warping() const { return level > 0; }
+
+  // what the last frames really ran at, steps per frame can fall short of
+  // the factor
+  float effective() const { return warping() ? static_cast<float>(effectiveWarp) : 1.f; }
+
+  // most steps to run this frame, normal at 1x
+  unsigned maxSteps(unsigned normal) const {
+    if (!warping())
+      return normal;
+
+    unsigned affordable = static_cast<unsigned>(budgetMs / std::max(stepMs, 0.01));
+    return std::clamp(affordable, normal, static_cast<unsigned>(normal * factor()));
+  }
+
+  // after each frame: the steps run, how long they took and the frame's
+  // real time
+  void measured(unsigned steps, double ms, float stepSeconds, float frameSeconds) {
+    if (steps > 0) {
+      stepMs += 0.1 * (ms / steps - stepMs);
+    }
+    if (frameSeconds > 0.f) {
+      effectiveWarp += 0.1 * (steps * stepSeconds / frameSeconds - effectiveWarp);
+    }
+  }
+
+private:
+  static constexpr std::size_t LEVELS = 7;
+  static constexpr float FACTORS[LEVELS] = {1.f, 2.f, 5.f, 10.f, 20.f, 50.f, 100.f};
+
+  std::size_t level = 0;
+  double budgetMs;
+  double stepMs = 1.0;        // average cost of a step
+  double effectiveWarp = 1.0; // average sim seconds per real second
+};
+
+///////////////////////////////////////////////////////////////////////////////
+// RENDER INTERPOLATION
+///////////////////////////////////////////////////////////////////////////////
+// The previous sim state of everything that's drawn, so a frame can be drawn
+// alpha of the way from the previous step to the current one. capture()
+// before the frame's last step. The state is kept by entity slot, an entity
+// that didn't exist at the capture is just drawn where it is.
+class RenderInterpolation {
+public:
+  explicit RenderInterpolation(Coordinator &ecs) : ecs(ecs) {}
+
+  void capture() {
+    ecs.each<Position, Rotation, SpriteComponent>([this](Entity e, Position &pos, Rotation &rot, SpriteComponent &) {
+      std::uint32_t slot = entityIndex(e);
+      if (slot >= previous.size()) {
+        previous.resize(slot + 1);
+      }
+      previous[slot] = Transform{e, pos.value, rot.angle};
+    });
+  }
+
+  sf::Vector2f position(Entity e, const Position &pos, float alpha) const {
+    const Transform *last = find(e);
+    return last ? last->position + (pos.value - last->position) * alpha : pos.value;
+  }
+
+  // the short way round, a turn across +/-180 doesn't spin the sprite
+  float angle(Entity e, const Rotation &rot, float alpha) const {
+    const Transform *last = find(e);
+    return last ? last->angle + normalizeAngle(rot.angle - last->angle) * alpha : rot.angle;
+  }
+
+private:
+  struct Transform {
+    Entity entity = NULL_ENTITY;
+    sf::Vector2f position;
+    float angle = 0.f;
+  };
+
+  Coordinator &ecs;
+  std::vector<Transform> previous; // by entity slot
+
+  const Transform *find(Entity e) const {
+    std::uint32_t slot = entityIndex(e);
+    return slot < previous.size() && previous[slot].entity == e ? &previous[slot] : nullptr;
+  }
+};
@@ -2,7 +2,6 @@
 #include "components.hpp"
 #include "ecs.hpp"
 #include "utils.hpp"
-#include <SFML/Audio.hpp>
 #include <SFML/Graphics.hpp>
 #include <SFML/System/Vector2.hpp>
 #include <cmath>
@@ -17,8 +16,9 @@ struct NullBuffer : std::streambuf {
   int overflow(int c) override { return c; } // do nothing
 };
 
-static NullBuffer nullBuffer; // global null buffer to use for cout
-static std::ostream nullStream(&nullBuffer); // global null stream to use for cout
+// one per thread, Update() runs on the ECS thread pool
+static thread_local NullBuffer nullBuffer;
+static thread_local std::ostream nullStream(&nullBuffer);
 
 #define TORPEDO_DEBUG nullStream
 
@@ -38,32 +38,32 @@ public:
   ~TorpedoAI() = default;
 
   // Update Torpedo Targeting
-  void Update(float tt, float dt) {
+  void Update([[maybe_unused]] float tt, [[maybe_unused]] float dt) {
 
     float const max_lateral_accel = 1500.f; // maximum lateral acceleration (thrusters) for torpedos
  
-    // need to get all the torpedos, find their targets and turn towards them
-    for (auto &torpedo :
-         ecs.view<Position, Velocity, Acceleration, Rotation, TorpedoTarget, TorpedoControl>()) {
+    // need to get all the torpedos, find their targets and turn towards them.
+    // Each torpedo only writes its own components and reads its target ship,
+    // so they're steered in parallel. The guidance is plenty of work for one
+    // torpedo per task, there are only ever a few dozen of them.
+    ecs.parallelEach<Position, Velocity, Acceleration, Rotation, TorpedoTarget, TorpedoControl>(
+        1, [&](Entity torpedo, Position &torpedoPos, Velocity &velocity, Acceleration &acceleration,
+            Rotation &torpedoRot, TorpedoTarget &torpedoTarget, TorpedoControl &torpedoControl) {
 
-      auto &torpedoPos = ecs.getComponent<Position>(torpedo);
-      auto &torpedoRot = ecs.getComponent<Rotation>(torpedo);
-      auto &torpedoVel = ecs.getComponent<Velocity>(torpedo).value;
-      auto &torpedoAcc = ecs.getComponent<Acceleration>(torpedo).value;
-      auto &torpedoControl = ecs.getComponent<TorpedoControl>(torpedo);
+      auto &torpedoVel = velocity.value;
+      auto &torpedoAcc = acceleration.value;
 
-      Entity target = ecs.getComponent<TorpedoTarget>(torpedo).target;
+      Entity target = torpedoTarget.target;
 
       // it is possible that the target has been destroyed
-      if (ecs.isAlive(target) == false) {
+      if (!ecs.valid(target)) {
         // if the target is not alive, remove the torpedo target component
         // TODO: will need some way to reaquire another target
-        continue; // skip to the next torpedo
+        return; // skip to the next torpedo
       }
 
       auto &targetPos = ecs.getComponent<Position>(target);
       auto &targetVel = ecs.getComponent<Velocity>(target).value;
-      auto &targetAcc = ecs.getComponent<Acceleration>(target).value;
 
       // get the angle to the target
       float att = angleToTarget(torpedoPos.value, targetPos.value);
@@ -195,7 +195,7 @@ public:
       }
       else {
         engine_accel = 0.f;
-        std::cout << "TorpedoAI not accelerating, angle to target: " << att << ", torpedo angle: " << torpedoRot.angle << "\n";
+        TORPEDO_DEBUG << "TorpedoAI not accelerating, angle to target: " << att << ", torpedo angle: " << torpedoRot.angle << "\n";
       }
 #else
       engine_accel = 2000.f;
@@ -257,7 +257,6 @@ public:
       }
 #endif
       TORPEDO_DEBUG << "TorpedoAI lateral heading rate: " << omega << "\n";
-      std::cout << "TorpedoAI lateral heading rate: " << omega << "\n";
 
       // turn towards the target, also apply extra turn from the lateral thrust.
       if (torpedoControl.turning == false) {
@@ -280,7 +279,7 @@ public:
       // TODO: not getting torpedo acc from launcher atm
       // torpedoAcc.y = std::sin((torpedoRot.angle) * (M_PI / 180.f)) * 1000.f;
       // torpedoAcc.x = std::cos((torpedoRot.angle) * (M_PI / 180.f)) * 1000.f;
-    }
+    });
   }
 
 private:
@@ -4,7 +4,6 @@
 #include "components.hpp"
 #include "utils.hpp"
 #include <cmath>
-#include <SFML/Audio.hpp>
 
 #undef TORPEDOTARGET_AI_DEBUG
 
@@ -46,14 +45,14 @@ public:
                   std::is_same_v<TargetType, FriendlyShipTarget>,
                   "TargetType must be EnemyShipTarget or FriendlyShipTarget");
 
-    Entity nearestShip = INVALID_TARGET_ID;  // so as not to confuse with the player 
+    Entity nearestShip = INVALID_TARGET_ID;
     float nearestShipDist = std::numeric_limits<float>::max();
 
     shipTargetDistances.clear(); // clear the map of torpedo distances
 
     // find target ships
     // find the nearest for range, and add to the shipTargetDistances
-    for (auto &ship : ecs.view<TargetType>()) {
+    for (auto &ship : ecs.group<TargetType>()) {
 
       // find the nearest ship to the player or enemy
       auto &enemyPos = ecs.getComponent<Position>(ship);
@@ -106,7 +105,7 @@ public:
     if (!shipTargetDistances.empty()) {
       auto it = shipTargetDistances.begin();
       std::advance(it, selectTargetIndex);  // get the next one
-      if (ecs.isAlive(it->second)) {
+      if (ecs.valid(it->second)) {
         return ecs.getEntityName(it->second);
       }
     }
@@ -145,7 +144,7 @@ public:
   }
 
   sf::String getLauncher1Target() {
-    if (launcher1Target != INVALID_TARGET_ID && ecs.isAlive(launcher1Target)) {
+    if (ecs.valid(launcher1Target)) {
       return ecs.getEntityName(launcher1Target);
     }
     else 
@@ -153,7 +152,7 @@ public:
   }
 
   sf::String getLauncher2Target() {
-    if (launcher2Target != INVALID_TARGET_ID && ecs.isAlive(launcher2Target)) {
+    if (ecs.valid(launcher2Target)) {
       return ecs.getEntityName(launcher2Target);
     }
     else 
@@ -164,7 +163,7 @@ public:
     auto &launcher1 = ecs.getComponent<TorpedoLauncher1>(e);
     auto &launcher2 = ecs.getComponent<TorpedoLauncher2>(e);
 
-    if (launcher1Target != INVALID_TARGET_ID) {
+    if (ecs.valid(launcher1Target)) {
       if ((launcher1.timeSinceFired == 0.f || tt > launcher1.timeSinceFired + launcher1.cooldown) && 
         launcher1.rounds) {
         launcher1.timeSinceFired = tt;
@@ -175,7 +174,7 @@ public:
       }
     }
 
-    if (launcher2Target != INVALID_TARGET_ID) {
+    if (ecs.valid(launcher2Target)) {
       if ((launcher2.timeSinceFired == 0.f || tt > launcher2.timeSinceFired + launcher2.cooldown) && 
         launcher2.rounds) {
         launcher2.timeSinceFired = tt;
@@ -188,7 +187,7 @@ public:
   }
 
 private:
-  const Entity INVALID_TARGET_ID = 0xFFFF; // used to indicate no target
+  const Entity INVALID_TARGET_ID = NULL_ENTITY; // used to indicate no target
   Coordinator &ecs;
   Entity e;        // player or enemy that is using the torpedos
   TorpedoFactory &torpedoFactory;
@@ -5,14 +5,8 @@
 #include <SFML/System/Vector2.hpp>
 #include <algorithm>
 #include <cmath>
-
-inline float randFloat(float min, float max) {
-  return min + static_cast<float>(rand()) / (static_cast<float>(RAND_MAX / (max - min)));
-}
-
-inline float randInt(int min, int max) {
-  return static_cast<float>(min + rand() % (max - min + 1));
-}
+#include <unordered_map>
+#include <vector>
 
 // check if an angle is within a range, considering wrap-around
 inline bool isInRange(float angle, float minAngle, float maxAngle) {
@@ -60,6 +54,17 @@ inline sf::Vector2f rotateVector(const sf::Vector2f& vec, float angleDegrees) {
     };
 }
 
+// e's cached orientation, refreshed first if e has turned since the physics
+// pass (the AIs and the player's controls turn ships later in the tick)
+inline const Orientation &currentOrientation(Coordinator &ecs, Entity e) {
+  auto &orientation = ecs.getComponent<Orientation>(e);
+  float angle = ecs.getComponent<Rotation>(e).angle;
+  if (orientation.angle != angle) {
+    orientation.set(angle);
+  }
+  return orientation;
+}
+
 
 inline void startTurn(Coordinator &ecs, ShipControl &shipControl, Entity e, float angle) {
 
@@ -345,20 +350,56 @@ inline void updateControlState(Coordinator &ecs, ShipControl &shipControl, Entit
 
 
 
-// return true if there is a torpedo targeting the entity
-inline bool torpedoThreatDetect(Coordinator &ecs, Entity e, const float torpedoThreatRange) {
-    Entity nearestTorpedo = 0xFFFF;  // so as not to confuse with the player 
-    float nearestTorpedoDist = std::numeric_limits<float>::max();
+// The torpedoes in flight at each ship, kept in step by ECS observers so
+// nothing has to look through every torpedo to find the ones aimed at it.
+// Not copyable, the observers point back at it.
+class IncomingTorpedoes {
+public:
+  explicit IncomingTorpedoes(Coordinator &ecs) {
+    ecs.onAdd<TorpedoTarget>([this](Entity torpedo, TorpedoTarget &torpedoTarget) {
+      byTarget[torpedoTarget.target].push_back(torpedo);
+    });
 
-    // find target torpedos
-    for (auto &torpedo : ecs.view<TorpedoTarget>()) {
-      auto &torpedoTarget = ecs.getComponent<TorpedoTarget>(torpedo);
+    ecs.onRemove<TorpedoTarget>([this](Entity torpedo, TorpedoTarget &torpedoTarget) {
+      auto target = byTarget.find(torpedoTarget.target);
+      if (target == byTarget.end())
+        return;
 
-      if (torpedoTarget.target != e) {
-        // skip if the torpedo is not targeting this entity
-        continue;
+      auto &torpedoes = target->second;
+      auto it = std::find(torpedoes.begin(), torpedoes.end(), torpedo);
+      if (it != torpedoes.end()) {
+        *it = torpedoes.back();
+        torpedoes.pop_back();
       }
 
+      // don't keep an entry per ship that was ever shot at
+      if (torpedoes.empty())
+        byTarget.erase(target);
+    });
+  }
+
+  IncomingTorpedoes(const IncomingTorpedoes &) = delete;
+  IncomingTorpedoes &operator=(const IncomingTorpedoes &) = delete;
+
+  // the torpedoes targeting e
+  const std::vector<Entity> &at(Entity e) const {
+    auto it = byTarget.find(e);
+    return it != byTarget.end() ? it->second : none;
+  }
+
+private:
+  std::unordered_map<Entity, std::vector<Entity>> byTarget;
+  std::vector<Entity> none;
+};
+
+// return true if there is a torpedo targeting the entity
+inline bool torpedoThreatDetect(Coordinator &ecs, const IncomingTorpedoes &incoming, Entity e,
+                                const float torpedoThreatRange) {
+    Entity nearestTorpedo = NULL_ENTITY;
+    float nearestTorpedoDist = std::numeric_limits<float>::max();
+
+    // find target torpedos
+    for (Entity torpedo : incoming.at(e)) {
       // find the nearest torpedo to the player or enemy
       auto &torpedoPos = ecs.getComponent<Position>(torpedo);
       auto &myPos = ecs.getComponent<Position>(e);
@@ -372,7 +413,7 @@ inline bool torpedoThreatDetect(Coordinator &ecs, Entity e, const float torpedoT
     }
 
     // no torpedos to target
-    if (nearestTorpedo == 0) {
+    if (nearestTorpedo == NULL_ENTITY) {
       return false;
     }
 
@@ -386,47 +427,34 @@ inline bool torpedoThreatDetect(Coordinator &ecs, Entity e, const float torpedoT
     return true; // there is a torpedo to target
   }
 
-// TODO: Make sure that all components are removed here, 
-// will need to add new components especially when destroying ships. 
-inline void destroyEntity(Coordinator &ecs, Entity e) {
-
-  ecs.removeComponent<SpriteComponent>(e);
-
-  // keep for player, so we dont crash
-  if (e != 0) {
-    ecs.removeComponent<Position>(e);
-    ecs.removeComponent<Velocity>(e);
-    ecs.removeComponent<Collision>(e);
-    ecs.removeComponent<Rotation>(e);
-    ecs.removeComponent<Health>(e);
-
-    if (ecs.hasComponent<TorpedoTarget>(e))
-      ecs.removeComponent<TorpedoTarget>(e);
-
-    if (ecs.hasComponent<TorpedoControl>(e))
-      ecs.removeComponent<TorpedoControl>(e);
-
-    if (ecs.hasComponent<TimeFired>(e))
-      ecs.removeComponent<TimeFired>(e);
+// the threat rings drawn round the player, in world units
+constexpr float BEST_PDC_RANGE = 8000.f;
+constexpr float PDC_THREAT_RANGE = 16000.f;
+constexpr float TORPEDO_THREAT_RANGE = 45000.f;
 
-    if (ecs.hasComponent<TorpedoLauncher1>(e))
-      ecs.removeComponent<TorpedoLauncher1>(e);
+// return true if a ship of TargetType (EnemyShipTarget or FriendlyShipTarget)
+// is within range of e
+template <typename TargetType> bool shipThreatDetect(Coordinator &ecs, Entity e, const float range) {
+  const sf::Vector2f myPos = ecs.getComponent<Position>(e).value;
 
-    if (ecs.hasComponent<TorpedoLauncher2>(e))
-      ecs.removeComponent<TorpedoLauncher2>(e);
-
-    if (ecs.hasComponent<FriendlyShipTarget>(e))
-      ecs.removeComponent<FriendlyShipTarget>(e);
-
-    if (ecs.hasComponent<EnemyShipTarget>(e))
-      ecs.removeComponent<EnemyShipTarget>(e);
-
-    if (ecs.hasComponent<DrivePlume>(e))
-      ecs.removeComponent<DrivePlume>(e);
+  for (Entity ship : ecs.group<TargetType>()) {
+    if (ship != e && distance(myPos, ecs.getComponent<Position>(ship).value) <= range) {
+      return true;
+    }
+  }
+  return false;
+}
 
-    if (ecs.hasComponent<PdcMounts>(e))
-      ecs.removeComponent<PdcMounts>(e);
+// Called from inside systems (collisions, damage), so the destroy is queued on
+// the command buffer and happens at the next ecs.flush(). The entity is no
+// longer valid() from here on. Destroying an entity drops all its components.
+inline void destroyEntity(Coordinator &ecs, Entity e) {
 
-    ecs.destroyEntity(e);
+  // keep for player, so we dont crash, just stop drawing it
+  if (e == 0) {
+    ecs.commands().removeComponent<SpriteComponent>(e);
+    return;
   }
+
+  ecs.commands().destroyEntity(e);
 }
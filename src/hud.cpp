@@ -15,8 +15,9 @@
 #include <sys/types.h>
 
 
-HUD::HUD(Coordinator& ecs, Entity player, TorpedoTargeting &torpedoTargeting) :
-    ecs(ecs), player(player), torpedoTargeting(torpedoTargeting) {
+HUD::HUD(Coordinator& ecs, Entity player, TorpedoTargeting &torpedoTargeting, const IncomingTorpedoes &incoming) :
+    ecs(ecs), player(player), torpedoTargeting(torpedoTargeting), incoming(incoming),
+    torpedoName(ecs.internName("Torpedo")), healthChanged(ecs.changed<Health>()) {
 
     // Load the font
     if (!font.openFromFile("../assets/fonts/FiraCodeNerdFont-Medium.ttf")) {
@@ -36,6 +37,12 @@ void HUD::DrawHUD(sf::RenderWindow &window, Entity enemy1, Entity enemy2, Entity
   screenHeight = window.getSize().y;
   screenCentre = {screenWidth / 2.f, screenHeight / 2.f};
 
+  // drop the health text of ships that have been hit, it's rebuilt on draw
+  for (Entity e : healthChanged.entities()) {
+    healthText.erase(e);
+  }
+  healthChanged.clear();
+
   // Sidebar
   sf::RectangleShape sidebarLeft({180.f, static_cast<float>(screenHeight)});
   sf::Vector2f sidebarLeftPosition = {0.f, 0.f};
@@ -57,26 +64,28 @@ void HUD::DrawHUD(sf::RenderWindow &window, Entity enemy1, Entity enemy2, Entity
 
   DrawTorpedoThreat(window);
 
+  DrawTimeWarp(window);
+
   DrawTorpedoTargetingText (window);
 
-  if (ecs.isAlive(player)) {
+  if (ecs.valid(player)) {
     DrawSidebarText(window, player, SidebarPosition::LEFT_BOTTOM);
     DrawShipNames(window, player, zoomFactor);
     DrawPlayerPdcOverlay(window, player, zoomFactor);
     DrawVectorOverlay(window, player, zoomFactor);
   }
 
-  if (ecs.isAlive(enemy1)) {
+  if (ecs.valid(enemy1)) {
     DrawSidebarText(window, enemy1, SidebarPosition::RIGHT_TOP);
     DrawShipNames(window, enemy1, zoomFactor);
   }
 
-  if (ecs.isAlive(enemy2)) {
+  if (ecs.valid(enemy2)) {
     DrawSidebarText(window, enemy2, SidebarPosition::RIGHT_MIDDLE);
     DrawShipNames(window, enemy2, zoomFactor);
   }
 
-  if (ecs.isAlive(enemy3)) {
+  if (ecs.valid(enemy3)) {
     DrawSidebarText(window, enemy3, SidebarPosition::LEFT_TOP);
     DrawShipNames(window, enemy3, zoomFactor);
   }
@@ -87,7 +96,7 @@ void HUD::DrawHUD(sf::RenderWindow &window, Entity enemy1, Entity enemy2, Entity
 
 void HUD::DrawTorpedoThreat(sf::RenderWindow & window) {
 
-  if (torpedoThreatDetect(ecs, player, torpedoThreatRange)) {
+  if (torpedoThreatDetect(ecs, incoming, player, torpedoThreatRange)) {
 
     // Draw a red box
     sf::RectangleShape threatBox({160.f, 30.f});
@@ -106,6 +115,35 @@ void HUD::DrawTorpedoThreat(sf::RenderWindow & window) {
   }
 }
 
+void HUD::setTimeWarp(float factor, float effective) {
+  timeWarp = factor;
+  effectiveTimeWarp = effective;
+}
+
+void HUD::DrawTimeWarp(sf::RenderWindow & window) {
+
+  if (timeWarp <= 1.f) {
+    return;
+  }
+
+  // the requested warp, and what the sim is really managing if it's short
+  char buf[48];
+  if (effectiveTimeWarp < timeWarp * 0.9f) {
+    std::snprintf(buf, sizeof(buf), "TIME WARP %.0fx (%.0fx)", timeWarp, effectiveTimeWarp);
+  }
+  else {
+    std::snprintf(buf, sizeof(buf), "TIME WARP %.0fx", timeWarp);
+  }
+
+  sf::Text text(font);
+  text.setString(buf);
+  text.setCharacterSize(20);
+  text.setFillColor(sf::Color(0x81, 0xb6, 0xbe));
+  sf::Vector2f textPosition = {screenCentre.x - 90.f, 20.f};
+  text.setPosition(textPosition);
+  window.draw(text);
+}
+
 void HUD::DrawTorpedoTargetingText(sf::RenderWindow & window) {
 
   char buf[32];
@@ -184,7 +222,10 @@ void HUD::DrawSidebarText(sf::RenderWindow& window, Entity e, SidebarPosition po
 
   // Health
   sf::Text healthtext(font);
-  sf::String healthString = std::string("Health: ") + std::to_string(ecs.getComponent<Health>(e).value);
+  std::string &healthString = healthText[e];
+  if (healthString.empty()) {
+    healthString = std::string("Health: ") + std::to_string(ecs.getComponent<Health>(e).value);
+  }
   healthtext.setString(healthString);
   healthtext.setCharacterSize(10);
   healthtext.setFillColor(sf::Color(0x81, 0xb6, 0xbe));
@@ -324,7 +365,7 @@ void HUD::DrawPlayerPdcOverlay (sf::RenderWindow& window, Entity e, float zoomFa
   }
 
   auto &ppos = ecs.getComponent<Position>(e);
-  auto prot = ecs.getComponent<Rotation>(e);
+  const Orientation orientation = currentOrientation(ecs, e);
 
   sf::Vector2f cameraOffset = screenCentre - (ppos.value / zoomFactor);
 
@@ -357,12 +398,12 @@ void HUD::DrawPlayerPdcOverlay (sf::RenderWindow& window, Entity e, float zoomFa
                              static_cast<float>(std::sin((pdc6.firingAngle) * (M_PI / 180.f)) * 200.f)};
 
   // fire from the actual pdc, not the centre of the ship
-  sf::Vector2f pdc1Offset = rotateVector({pdc1.positionx, pdc1.positiony}, prot.angle);
-  sf::Vector2f pdc2Offset = rotateVector({pdc2.positionx, pdc2.positiony}, prot.angle);
-  sf::Vector2f pdc3Offset = rotateVector({pdc3.positionx, pdc3.positiony}, prot.angle);
-  sf::Vector2f pdc4Offset = rotateVector({pdc4.positionx, pdc4.positiony}, prot.angle);
-  sf::Vector2f pdc5Offset = rotateVector({pdc5.positionx, pdc5.positiony}, prot.angle);
-  sf::Vector2f pdc6Offset = rotateVector({pdc6.positionx, pdc6.positiony}, prot.angle);
+  sf::Vector2f pdc1Offset = orientation.rotate({pdc1.positionx, pdc1.positiony});
+  sf::Vector2f pdc2Offset = orientation.rotate({pdc2.positionx, pdc2.positiony});
+  sf::Vector2f pdc3Offset = orientation.rotate({pdc3.positionx, pdc3.positiony});
+  sf::Vector2f pdc4Offset = orientation.rotate({pdc4.positionx, pdc4.positiony});
+  sf::Vector2f pdc5Offset = orientation.rotate({pdc5.positionx, pdc5.positiony});
+  sf::Vector2f pdc6Offset = orientation.rotate({pdc6.positionx, pdc6.positiony});
 
   DrawVector(window, ecs, e, ppos.value + pdc1Offset, pdc1Vector, cameraOffset, sf::Color::Red, zoomFactor, 10.f);
   DrawVector(window, ecs, e, ppos.value + pdc2Offset, pdc2Vector, cameraOffset, sf::Color::Green, zoomFactor, 10.f);
@@ -419,9 +460,7 @@ void HUD::DrawTorpedoOverlay (sf::RenderWindow& window, float zoomFactor) {
   float radius = 0.5f + (80.f / zoomFactor);
 
   // need to get all the missiles
-  std::vector<Entity> torpedos = ecs.getEntitiesByName("Torpedo");
-
-  for (auto e : torpedos) {
+  for (auto e : ecs.getEntitiesByName(torpedoName)) {
 
     auto &ppos = ecs.getComponent<Position>(player);
     auto &tpos = ecs.getComponent<Position>(e);
@@ -470,9 +509,7 @@ void HUD::DrawEnemyShipOverlay (sf::RenderWindow& window, float zoomFactor) {
   float radius = 4.0f + (500.f / zoomFactor);
 
   // need to get all the enemy ships
-  std::vector<Entity> torpedos = ecs.getEntitiesByName("Torpedo");
-
-  for (auto e : ecs.view<EnemyShipTarget>()) {
+  for (auto e : ecs.group<EnemyShipTarget>()) {
 
     auto &ppos = ecs.getComponent<Position>(player);
     auto &tpos = ecs.getComponent<Position>(e);
@@ -1,16 +1,11 @@
-#include "../include/collision.hpp"
+#include "../include/assets.hpp"
 #include "../include/components.hpp"
 #include "../include/ecs.hpp"
-#include "../include/ballistics.hpp"
-#include "../include/enemyai.hpp"
-#include "../include/torpedoai.hpp"
-#include "../include/pdctarget.hpp"
-#include "../include/torpedotarget.hpp"
-#include "../include/explosion.hpp"
-#include "../include/damage.hpp"
 #include "../include/hud.hpp"
-#include "ships.cpp"
-#include "../include/asteroids.hpp"
+#include "../include/playerinput.hpp"
+#include "../include/replay.hpp"
+#include "../include/simulation.hpp"
+#include "../include/timestep.hpp"
 #include <SFML/Graphics.hpp>
 #include <SFML/Graphics/CircleShape.hpp>
 #include <SFML/Graphics/Rect.hpp>
@@ -18,9 +13,12 @@
 #include <SFML/System/Angle.hpp>
 #include <SFML/System/Vector2.hpp>
 #include <SFML/Window/Keyboard.hpp>
-#include <SFML/Audio.hpp>
+#include <chrono>
 #include <cmath>
 #include <cstdint>
+#include <cstdlib>
+#include <cstring>
+#include <ctime>
 #include <iostream>
 #include <sys/types.h>
 
@@ -29,158 +27,65 @@ void destroyEntity(Coordinator &ecs, Entity e);
 void DisplayWorldThreatRings(sf::RenderWindow& window, sf::Vector2f screenCentre, float zoomFactor);
 void DrawWorldRangeRings(sf::RenderWindow& window, sf::Vector2f centerWorldPos, float zoomFactor, int ringCount = 6);
 
-// use this to control the pdc targeting
-enum class State {
-  IDLE,
-  ATTACK_PDC,
-  DEFENCE_PDC,
-};
+PlayerInput sampleInput(const sf::RenderWindow &window, sf::Vector2f screenCentre);
 
 
-int main() {
+int main(int argc, char *argv[]) {
+
+  // simulation rate, independent of the frame rate:
+  //   --tick-rate <hz>   sim steps per second (default 120)
+  //   --max-steps <n>    most steps to catch up in one frame (default 8)
+  // and to play a game again:
+  //   --seed <n>         the random seed (default from the clock)
+  //   --record <file>    save the game for roci-sim --replay
+  float tickRate = 120.f;
+  unsigned maxSteps = 8;
+  std::uint64_t seed = static_cast<std::uint64_t>(std::time(nullptr));
+  const char *recordPath = nullptr;
+  for (int i = 1; i + 1 < argc; i += 2) {
+    if (std::strcmp(argv[i], "--tick-rate") == 0) {
+      tickRate = std::strtof(argv[i + 1], nullptr);
+    }
+    else if (std::strcmp(argv[i], "--max-steps") == 0) {
+      maxSteps = static_cast<unsigned>(std::strtoul(argv[i + 1], nullptr, 10));
+    }
+    else if (std::strcmp(argv[i], "--seed") == 0) {
+      seed = std::strtoull(argv[i + 1], nullptr, 10);
+    }
+    else if (std::strcmp(argv[i], "--record") == 0) {
+      recordPath = argv[i + 1];
+    }
+  }
+  std::cout << "Seed: " << seed << "\n";
 
   auto window = sf::RenderWindow(sf::VideoMode({1920u, 1080u}), "Rocinante",
                                  sf::Style::None);
   window.setFramerateLimit(60);
 
-  State state = State::IDLE;
-
-  std::vector<Explosion> explosions;
-
-  ///////////////////////////////////////////////////////////////////////////////
-  // - ECS Setup -
-  ///////////////////////////////////////////////////////////////////////////////
-  Coordinator ecs;
-  ecs.registerComponent<Position>();
-  ecs.registerComponent<Velocity>();
-  ecs.registerComponent<Acceleration>();
-  ecs.registerComponent<Rotation>();
-  ecs.registerComponent<SpriteComponent>();
-  ecs.registerComponent<Health>();
-  ecs.registerComponent<Pdc>();
-  ecs.registerComponent<TorpedoLauncher1>();
-  ecs.registerComponent<TorpedoLauncher2>();
-  ecs.registerComponent<Collision>();
-  ecs.registerComponent<TorpedoTarget>();
-  ecs.registerComponent<TimeFired>();
-  ecs.registerComponent<PdcMounts>();
-  ecs.registerComponent<TorpedoControl>();
-  ecs.registerComponent<EnemyShipTarget>();
-  ecs.registerComponent<FriendlyShipTarget>();
-  ecs.registerComponent<ShipControl>();
-  ecs.registerComponent<DrivePlume>();
-
   ///////////////////////////////////////////////////////////////////////////////
-  // - Load Textures -
+  // - Load Textures and Sounds -
   ///////////////////////////////////////////////////////////////////////////////
-  sf::Texture rociTexture, belterFrigateTexture, bulletTexture, torpedoTexture,
-              explosionTexture, pellaTexture, driveTexture, pellaDriveTexture;
-
-  if (!rociTexture.loadFromFile("../assets/textures/roci.png")) {
-    std::cout << "Error loading texture" << std::endl;
-    return -1;
-  }
-  std::cout << "Roci x " << rociTexture.getSize().x << " y "
-            << rociTexture.getSize().y << "\n";
-
-  if (!belterFrigateTexture.loadFromFile("../assets/textures/bashi-bazouk.png")) {
-    std::cout << "Error loading texture" << std::endl;
-    return -1;
-  }
-
-  if (!pellaTexture.loadFromFile("../assets/textures/pella.png")) {
-    std::cout << "Error loading texture" << std::endl;
-    return -1;
-  }
-
-  if (!bulletTexture.loadFromFile("../assets/textures/pdc-bullet.png")) {
-    std::cout << "Error loading texture" << std::endl;
-    return -1;
-  }
-
-  if (!torpedoTexture.loadFromFile("../assets/textures/torpedo.png")) {
-    std::cout << "Error loading texture" << std::endl;
-    return -1;
-  }
-
-  if (!explosionTexture.loadFromFile("../assets/textures/explosion_sheet.png")) {
-    std::cout << "Error loading texture" << std::endl;
-    return -1;
-  }
-
-  if (!driveTexture.loadFromFile("../assets/textures/drive.png")) {
-    std::cout << "Error loading texture" << std::endl;
-    return -1;
-  }
-
-if (!pellaDriveTexture.loadFromFile("../assets/textures/pella-drive.png")) {
-    std::cout << "Error loading texture" << std::endl;
+  Assets assets;
+  if (!assets.load(false)) {
     return -1;
   }
+  std::cout << "Roci x " << assets.roci.size.x << " y " << assets.roci.size.y << "\n";
 
   ///////////////////////////////////////////////////////////////////////////////
-  // - Load Sounds -
+  // - Create the world: ships, asteroids, AIs and systems -
   ///////////////////////////////////////////////////////////////////////////////
-  sf::SoundBuffer pdcFireSoundBuffer;
-  if (!pdcFireSoundBuffer.loadFromFile("../assets/sounds/pdc.wav")) {
-    std::cout << "Error loading sound" << std::endl;
-    return -1;
-  }
-  sf::Sound pdcFireSoundPlayer(pdcFireSoundBuffer);
+  FixedTimestep timestep(tickRate, maxSteps);
+  const float dt = timestep.step(); // every system steps the sim by the same dt
 
-  sf::SoundBuffer pdcHitSoundBuffer;
-  if (!pdcHitSoundBuffer.loadFromFile("../assets/sounds/pdc-hit.wav")) {
-    std::cout << "Error loading sound" << std::endl;
-    return -1;
-  }
-  sf::Sound pdcHitSoundPlayer(pdcHitSoundBuffer);
+  Simulation sim(assets, dt, seed);
+  Coordinator &ecs = sim.ecs;
+  const Entity player = sim.player;
+  TorpedoTargeting &torpedoTargeting = sim.torpedoTargeting;
 
-  sf::SoundBuffer explosionSoundBuffer;
-  if (!explosionSoundBuffer.loadFromFile("../assets/sounds/explosion.wav")) {
-    std::cout << "Error loading sound" << std::endl;
-    return -1;
-  }
-  sf::Sound explosionSoundPlayer(explosionSoundBuffer);
+  // every step's input and world hash, saved at the end with --record
+  ReplayLog replay(seed, dt);
 
-  ///////////////////////////////////////////////////////////////////////////////
-  // - Create Ship Entities -
-  ///////////////////////////////////////////////////////////////////////////////
-
-  PlayerShipFactory playerShipFactory(ecs, rociTexture, driveTexture);
-  Entity player = playerShipFactory.createPlayerShip("Rocinante", 1300); // just for testing
-
-  BelterFrigateShipFactory belterShipFactory(ecs, belterFrigateTexture, driveTexture);
-  Entity enemy1 = belterShipFactory.createBelterFrigateShip(
-      "Bashi Bazouk", {14000.f, -280000.f}, {0.f, 0.f}, 90.f, 200);
-
-  Entity enemy2 = belterShipFactory.createBelterFrigateShip(
-      "Behemoth", {-50000.f, -280000.f}, {0.f, 0.f}, 90.f, 200);
-
-  BelterPellaShipFactory pellaShipFactory(ecs, pellaTexture, pellaDriveTexture);
-  Entity enemy3 = pellaShipFactory.createBelterPellaShip(
-      "Pella", {-30000.f, -300000.f}, {0.f, 0.f}, 90.f, 500);
-
-  std::cout << "Pella: " << enemy3 << "\n";
-
-  ///////////////////////////////////////////////////////////////////////////////
-  // Create Ballistics Factory
-  ///////////////////////////////////////////////////////////////////////////////
-  BulletFactory bulletFactory(ecs, bulletTexture);
-  TorpedoFactory torpedoFactory(ecs, torpedoTexture);
-
-  ///////////////////////////////////////////////////////////////////////////////
-  // Create Enemy and Torpedo AIs
-  ///////////////////////////////////////////////////////////////////////////////
-  EnemyAI enemy1AI(ecs, enemy1, bulletFactory, torpedoFactory, pdcFireSoundPlayer);
-  EnemyAI enemy2AI(ecs, enemy2, bulletFactory, torpedoFactory, pdcFireSoundPlayer);
-  EnemyAI enemy3AI(ecs, enemy3, bulletFactory, torpedoFactory, pdcFireSoundPlayer);
-  TorpedoAI torpedoAI(ecs);
-
-  // Create PDC Targeting System for player
-  PdcTargeting pdcTargeting(ecs, player, bulletFactory, pdcFireSoundPlayer);
-
-  // create torpedo targeting for player
-  TorpedoTargeting torpedoTargeting(ecs, player, torpedoFactory);
+  std::cout << "Pella: " << sim.enemy3 << "\n";
 
   ///////////////////////////////////////////////////////////////////////////////
   // Set up worldview
@@ -193,48 +98,39 @@ if (!pellaDriveTexture.loadFromFile("../assets/textures/pella-drive.png")) {
   float zoomFactor = 30.f;
   worldview.setSize({1920 * zoomFactor, 1080 * zoomFactor});
 
-  ///////////////////////////////////////////////////////////////////////////////
-  // create Asteroids
-  ///////////////////////////////////////////////////////////////////////////////
-  AsteroidFactory asteroidFactory(ecs);
-  asteroidFactory.createInitialAsteroids();
-
-  ///////////////////////////////////////////////////////////////////////////////
-  // Create Collision System
-  ///////////////////////////////////////////////////////////////////////////////
-  CollisionSystem collisionSystem(ecs, pdcHitSoundPlayer, explosionSoundPlayer,
-                                 explosions, explosionTexture, asteroidFactory);
-
-  ///////////////////////////////////////////////////////////////////////////////
-  // Create Damage System
-  ///////////////////////////////////////////////////////////////////////////////
-  DamageSystem damageSystem(ecs, explosionSoundPlayer,
-                            explosions, explosionTexture);
- 
   ///////////////////////////////////////////////////////////////////////////////
   // create the HUD object
   ///////////////////////////////////////////////////////////////////////////////
-  HUD hud(ecs, player, torpedoTargeting);
+  HUD hud(ecs, player, torpedoTargeting, sim.incomingTorpedoes);
 
 
   sf::Clock clock;
-  float tt = 0; // total time for weapon cooldown
+  RenderInterpolation interpolation(ecs);
+
+  // time compression for the transits: . faster, , slower, / back to 1x
+  TimeWarp timeWarp;
+
+  // a torpedo or an enemy ship inside the outer threat ring, no time warp then
+  auto threatened = [&] {
+    return ecs.valid(player) &&
+           (torpedoThreatDetect(ecs, sim.incomingTorpedoes, player, TORPEDO_THREAT_RANGE) ||
+            shipThreatDetect<EnemyShipTarget>(ecs, player, TORPEDO_THREAT_RANGE));
+  };
 
-  float constAccelGs = 0;
+  sf::Vector2f screenCentre;
+
+  // one-shot key releases, they go to the next sim step
+  std::uint16_t pendingButtons = 0;
 
   while (window.isOpen()) {
-    float dt = clock.restart().asSeconds();
-    tt += dt;
+    float frameTime = clock.restart().asSeconds();
 
     // this is the main space window. Render this first, then render the HUD
     window.setView(worldview);
 
     u_int16_t screenWidth = window.getSize().x;
     u_int16_t screenHeight = window.getSize().y;
-    sf::Vector2f screenCentre = {screenWidth / 2.f, screenHeight / 2.f};
-
-    // main ship control structure
-    auto &shipControl = ecs.getComponent<ShipControl>(player);
+    screenCentre = {screenWidth / 2.f, screenHeight / 2.f};
 
     ///////////////////////////////////////////////////////////////////////////////
     // - Events -
@@ -254,28 +150,49 @@ if (!pellaDriveTexture.loadFromFile("../assets/textures/pella-drive.png")) {
 
         // use key released for single press of the T key for next torpedo target
         if (keyPressed->scancode == sf::Keyboard::Scancode::T) {
-          torpedoTargeting.selectNextTarget();
+          pendingButtons |= PlayerInput::NEXT_TARGET;
         }
         else if (keyPressed->scancode == sf::Keyboard::Scancode::Num1) {
           // assign to launcher 1
-          torpedoTargeting.setLauncher1Target( torpedoTargeting.getTargetEntity());
+          pendingButtons |= PlayerInput::ASSIGN_LAUNCHER1;
         }
         else if (keyPressed->scancode == sf::Keyboard::Scancode::Num2) {
           // assign to launcher 2
-          torpedoTargeting.setLauncher2Target( torpedoTargeting.getTargetEntity());
+          pendingButtons |= PlayerInput::ASSIGN_LAUNCHER2;
         }
         else if (keyPressed->scancode == sf::Keyboard::Scancode::O) {
           hud.toggleOverlay();
         }
+        else if (keyPressed->scancode == sf::Keyboard::Scancode::P) {
+          // print how long each system is taking
+          for (auto &timing : sim.scheduler.timings()) {
+            std::cout << timing.name << ": " << timing.lastMs << " ms (avg " << timing.averageMs << " ms)\n";
+          }
+        }
         else if (keyPressed->scancode == sf::Keyboard::Scancode::K) {
           // increase constant acceleration
-          constAccelGs += 1.0;
-          constAccelGs = std::clamp(constAccelGs, 0.f, 10.f);
+          pendingButtons |= PlayerInput::MORE_ACCEL;
         }
         else if (keyPressed->scancode == sf::Keyboard::Scancode::J) {
           // decrease constant acceleration
-          constAccelGs -= 1.0;
-          constAccelGs = std::clamp(constAccelGs, 0.f, 10.f);
+          pendingButtons |= PlayerInput::LESS_ACCEL;
+        }
+        else if (keyPressed->scancode == sf::Keyboard::Scancode::Period) {
+          if (threatened()) {
+            std::cout << "Time warp: not with a threat in range\n";
+          }
+          else {
+            timeWarp.faster();
+            std::cout << "Time warp: " << timeWarp.factor() << "x\n";
+          }
+        }
+        else if (keyPressed->scancode == sf::Keyboard::Scancode::Comma) {
+          timeWarp.slower();
+          std::cout << "Time warp: " << timeWarp.factor() << "x\n";
+        }
+        else if (keyPressed->scancode == sf::Keyboard::Scancode::Slash) {
+          timeWarp.stop();
+          std::cout << "Time warp: off\n";
         }
       } else if (event->is<sf::Event::MouseWheelScrolled>()) {
         auto *scroll = event->getIf<sf::Event::MouseWheelScrolled>();
@@ -299,210 +216,49 @@ if (!pellaDriveTexture.loadFromFile("../assets/textures/pella-drive.png")) {
     }
 
     ///////////////////////////////////////////////////////////////////////////////
-    // - Physics: A->V->P -
-  ///////////////////////////////////////////////////////////////////////////////
-    for (auto e : ecs.view<Velocity, Acceleration>()) {
-      auto &vel = ecs.getComponent<Velocity>(e);
-      auto &acc = ecs.getComponent<Acceleration>(e);
-
-      // update velocity
-      vel.value += acc.value * dt;
-    }
-
-    for (auto e : ecs.view<Position, Velocity>()) {
-      auto &vel = ecs.getComponent<Velocity>(e);
-      auto &pos = ecs.getComponent<Position>(e);
-
-      // update position
-      pos.value += vel.value * dt;
-    }
-
-    for (auto e : ecs.view<Rotation>()) {
-
-      auto &rot = ecs.getComponent<Rotation>(e);
-
-      // update rotating objects
-      rot.angle = rot.angle + rot.angularVelocity * dt;
-    }
-
-    // Collision System - check for collisions
-    // check again later as sometimes only one of two missiles will hit
-    collisionSystem.Update();
-
-    ///////////////////////////////////////////////////////////////////////////////
-    // Keyboard and flip control
-    // dont use events for the keyboard, check if currently pressed.
+    // - Update - run all the systems once per fixed step this frame
     ///////////////////////////////////////////////////////////////////////////////
-
-    if (shipControl.state != ControlState::IDLE) {
-      ///////////////////////////////////////////////////////////////////////////////
-      // Control the flip or turns(if needed)
-      ///////////////////////////////////////////////////////////////////////////////
-      updateControlState(ecs, shipControl, player, tt, dt);
-    }
-    else if (shipControl.state == ControlState::IDLE) {
-
-      if (sf::Keyboard::isKeyPressed(sf::Keyboard::Key::H)) {
-        // rotate left
-        auto &rot = ecs.getComponent<Rotation>(player);
-        //rot.angle -= (window.getSize().x / 500.f);
-        rot.angle -= 90.f * dt;
-        rot.angle = normalizeAngle(rot.angle);
-      }
-      else if (sf::Keyboard::isKeyPressed(sf::Keyboard::Key::L)) {
-        // rotate right
-        auto &rot = ecs.getComponent<Rotation>(player);
-        // rot.angle += (window.getSize().x / 500.f);
-        rot.angle += 90.f * dt;
-        rot.angle = normalizeAngle(rot.angle);
+    // the keyboard and mouse are read once a frame, the key releases only go
+    // to the first step
+    PlayerInput held = sampleInput(window, screenCentre);
+
+    // time warp runs more steps per frame, as many as the frame budget allows
+    unsigned steps = timestep.advance(frameTime * timeWarp.factor(), timeWarp.maxSteps(maxSteps));
+    auto stepsStart = std::chrono::steady_clock::now();
+
+    for (unsigned step = 0; step < steps; ++step) {
+      // the state before the last step is what the render blends from
+      if (step + 1 == steps) {
+        interpolation.capture();
       }
 
-      if (sf::Mouse::isButtonPressed(sf::Mouse::Button::Left)) {
-        ///////////////////////////////////////////////////////////////////////////////
-        // Use the left mouse key to set rotation and acceleration
-        ///////////////////////////////////////////////////////////////////////////////
-
-        // turn off constant acceleration
-        constAccelGs = 0.f;
-
-        sf::Vector2i clickPosition = sf::Mouse::getPosition(window);
-        sf::Vector2f clickPositionf(static_cast<float>(clickPosition.x),
-                                    static_cast<float>(clickPosition.y));
+      PlayerInput input = held;
+      input.buttons |= pendingButtons;
+      pendingButtons = 0;
 
-        // convert to world coordinates, doesnt seem to work very well
-        // sf::Vector2f worldPosition = window.mapPixelToCoords(clickPosition);
-
-        auto &acc = ecs.getComponent<Acceleration>(player);
-        auto &vel = ecs.getComponent<Velocity>(player);
-        auto &rot = ecs.getComponent<Rotation>(player);
-
-        sf::Vector2f playerPos = ecs.getComponent<Position>(player).value;
-
-        sf::Vector2f cameraOffset = screenCentre - playerPos;
-        sf::Vector2f newVector = clickPositionf - playerPos - cameraOffset;
-
-        // std::cout << "new vector length " << newVector.length()
-        //           << " angle: " << newVector.angle().asDegrees() << "\n";
-
-        // turn towards the vector
-        if (newVector.length() > 0.f) {
-          // std::cout << "Turning towards vector: " << newVector.angle().asDegrees() << "\n";
-          startTurn(ecs, shipControl, player, newVector.angle().asDegrees()); 
-
-          float maxAccel = newVector.length() / 30.f; 
-          maxAccel = std::clamp(maxAccel, 0.f, 10.f); // limit to 10 Gs
- 
-          // use the distance from the mouse click to set acceleration, max 10 Gs
-          accelerateToMax(ecs, shipControl, player, maxAccel, dt);
-        }
+      sim.step(input);
+      if (recordPath) {
+        replay.record(input, hashWorld(ecs, sim.tt));
       }
-      else if (sf::Mouse::isButtonPressed(sf::Mouse::Button::Right)) {
-
-        // turn off constant acceleration
-        constAccelGs = 0.f;
 
-        ///////////////////////////////////////////////////////////////////////////////
-        // Use the right mouse key to strafe
-
-        ///////////////////////////////////////////////////////////////////////////////
-        sf::Vector2i clickPosition = sf::Mouse::getPosition(window);
-        sf::Vector2f clickPositionf(static_cast<float>(clickPosition.x),
-                                    static_cast<float>(clickPosition.y));
-
-        auto &acc = ecs.getComponent<Acceleration>(player);
-        auto &vel = ecs.getComponent<Velocity>(player);
-        auto &rot = ecs.getComponent<Rotation>(player);
-
-        sf::Vector2f playerPos = ecs.getComponent<Position>(player).value;
-
-        sf::Vector2f cameraOffset = screenCentre - playerPos;
-        sf::Vector2f newVector = clickPositionf - playerPos - cameraOffset;
-
-        // std::cout << "new vector length " << newVector.length()
-        //           << " angle: " << newVector.angle().asDegrees() << "\n";
-
-        // strafe towards the vector
-        if (newVector.length() > 0.f) {
-          // take this vector and strafe towards it
-
-          // vel.value.x += std::cos((newVector.angle().asRadians())) * 1000.f * dt;
-          // vel.value.y += std::sin((newVector.angle().asRadians())) * 1000.f * dt;
-          vel.value += newVector.normalized() * 500.f * dt;
-        }
-      }
-      else if (sf::Keyboard::isKeyPressed(sf::Keyboard::Key::S)) {
-        // flip and decelerate
-        // debounce the flip
-        // rotate to burn and reduce velocity, may not be 180 if there is 
-        // some lateral movement
-        startFlipAndStop(ecs, shipControl, player, 8.0f, tt);
-      }
-      else {
-        accelerateToMax(ecs, shipControl, player, constAccelGs, dt);
+      // out of time warp the moment anything gets close, the rest of the
+      // frame's steps are dropped
+      if (timeWarp.warping() && threatened()) {
+        timeWarp.stop();
+        std::cout << "Time warp: off, threat in range\n";
+        interpolation.capture();
+        steps = step + 1;
+        break;
       }
     }
- 
 
-    ///////////////////////////////////////////////////////////////////////////////
-    // Fire! Attacking PDCs
-    ///////////////////////////////////////////////////////////////////////////////
-    if (sf::Keyboard::isKeyPressed(sf::Keyboard::Key::E)) {
-      state = State::ATTACK_PDC;
-    }
+    timeWarp.measured(steps,
+                      std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - stepsStart).count(),
+                      dt, frameTime);
+    hud.setTimeWarp(timeWarp.factor(), timeWarp.effective());
 
-    ///////////////////////////////////////////////////////////////////////////////
-    // Fire! Defensive PDCs Change to defence state
-    ///////////////////////////////////////////////////////////////////////////////
-    if (sf::Keyboard::isKeyPressed(sf::Keyboard::Key::D)) {
-      state = State::DEFENCE_PDC;
-    }
-
-    ///////////////////////////////////////////////////////////////////////////////
-    // simple state machine 
-    // target all pdcs if attacking enemy, this updates the display of pdc target heading
-    ///////////////////////////////////////////////////////////////////////////////
-    if (state == State::ATTACK_PDC) {
-      // target the enemy
-      pdcTargeting.pdcAttack<EnemyShipTarget>(tt);
-    }
-    else if (state == State::DEFENCE_PDC) {
-      // target the nearest torpedo
-      pdcTargeting.pdcDefendTorpedo(tt, dt);
-    }
-
-    state = State::IDLE;
-
-    ///////////////////////////////////////////////////////////////////////////////
-    // Fire! Torpedo 1 & 2
-    ///////////////////////////////////////////////////////////////////////////////
-    if (sf::Keyboard::isKeyPressed(sf::Keyboard::Key::Space)) {
-      torpedoTargeting.fireBoth(tt);
-    }
-
-    ///////////////////////////////////////////////////////////////////////////////
-    // - Update everying else -
-    ///////////////////////////////////////////////////////////////////////////////
-    // Enemy & Torpedo AIs
-    torpedoTargeting.Update<EnemyShipTarget>(); // re-aquire targets for the torpedos
-    
-    if (ecs.isAlive(enemy1))
-      enemy1AI.Update(tt, dt);
-
-    if (ecs.isAlive(enemy2))
-      enemy2AI.Update(tt, dt);
-
-    if (ecs.isAlive(enemy3))
-      enemy3AI.Update(tt, dt);
-
-    torpedoAI.Update(tt, dt);
-    bulletFactory.Update(tt); // remove bullets that have been fired for too long
-
-    // Collision System - check for collisions again
-    // it is possible that two missiles have collided near a target, so we need to check again
-    collisionSystem.Update();
-
-    // DamageSystem
-    damageSystem.Update();
+    // how far the frame is between the last two sim steps
+    float alpha = timestep.alpha();
 
     ///////////////////////////////////////////////////////////////////////////////
     // - Render -
@@ -516,84 +272,66 @@ if (!pellaDriveTexture.loadFromFile("../assets/textures/pella-drive.png")) {
     ///////////////////////////////////////////////////////////////////////////////
     // draw all the sprites
     ///////////////////////////////////////////////////////////////////////////////
-    for (auto e : ecs.view<Position, Rotation, SpriteComponent>()) {
+    // everything is drawn alpha of the way between the last two sim steps,
+    // the camera too
+    sf::Vector2f playerPos;
+    if (ecs.valid(player)) {
+      playerPos = interpolation.position(player, ecs.getComponent<Position>(player), alpha);
+    }
+
+    for (auto [e, pos, rot, sc, dp] : ecs.range<Position, Rotation, SpriteComponent, Optional<DrivePlume>>()) {
 
-      auto &pos = ecs.getComponent<Position>(e);
-      auto &rot = ecs.getComponent<Rotation>(e);
-      auto &sc = ecs.getComponent<SpriteComponent>(e);
+      sf::Vector2f drawPos = interpolation.position(e, pos, alpha);
+      float drawAngle = interpolation.angle(e, rot, alpha);
 
-      sf::Angle angle = sf::degrees(rot.angle);
+      sf::Angle angle = sf::degrees(drawAngle);
       sc.sprite.setRotation(angle);
 
       // center the screen for the player
       if (e == player) {
         sc.sprite.setPosition(screenCentre);
       }
-      else if (ecs.isAlive(player)){               // possible the player is dead, dont want to crash
+      else if (ecs.valid(player)){               // possible the player is dead, dont want to crash
 
-        auto &playerpos = ecs.getComponent<Position>(player);
-
-        sf::Vector2f cameraOffset = screenCentre - playerpos.value;
-        sc.sprite.setPosition(pos.value + cameraOffset);
+        sf::Vector2f cameraOffset = screenCentre - playerPos;
+        sc.sprite.setPosition(drawPos + cameraOffset);
       }
 
       window.draw(sc.sprite);
 
       // check if we have a drive plume
-      if (ecs.hasComponent<DrivePlume>(e)) {
+      if (dp) {
         auto &acc = ecs.getComponent<Acceleration>(e);
-        auto &dp = ecs.getComponent<DrivePlume>(e);
         float accelLength = acc.value.length();
  
-        dp.sprite.setRotation(sf::degrees(rot.angle));
+        dp->sprite.setRotation(sf::degrees(drawAngle));
 
         // adjust the drive plume sprite based on the acceleration length
         if (accelLength > 0.f) {
-          dp.sprite.setScale(sf::Vector2f{5.f + (accelLength / 100.f), 5.f + (accelLength / 500.f)});
+          dp->sprite.setScale(sf::Vector2f{5.f + (accelLength / 100.f), 5.f + (accelLength / 500.f)});
         } else {
-          dp.sprite.setScale(sf::Vector2f{0.f, 0.f});
+          dp->sprite.setScale(sf::Vector2f{0.f, 0.f});
         }
 
+        // the plume sits behind the sprite as it's drawn, so it turns with the
+        // interpolated angle rather than the ship's cached Orientation
+        sf::Vector2f drivePlumePosition = Orientation(drawAngle).rotate(dp->offset);
+
         // center the screen for the player
         if (e == player) {
-          sf::Vector2f drivePlumePosition = rotateVector(dp.offset, rot.angle);
-          dp.sprite.setPosition(screenCentre + drivePlumePosition);
+          dp->sprite.setPosition(screenCentre + drivePlumePosition);
         } else {
-          sf::Vector2f drivePlumePosition = rotateVector(dp.offset, rot.angle);
-          auto &playerpos = ecs.getComponent<Position>(player);
-
-          sf::Vector2f cameraOffset = screenCentre - playerpos.value;
-          dp.sprite.setPosition(pos.value + cameraOffset + drivePlumePosition);
+          sf::Vector2f cameraOffset = screenCentre - playerPos;
+          dp->sprite.setPosition(drawPos + cameraOffset + drivePlumePosition);
         }
 
-        window.draw(dp.sprite);
+        window.draw(dp->sprite);
       }
     }
 
 
     // Draw the explosions
-    for (auto &explosion : explosions) explosion.Update(dt);
-
-    // Remove all finished explosions
-    //
-    // std::remove_if : This rearranges the vector so that all unwanted elements 
-    //                  (e.finished == true) are moved to the end. It returns an
-    //                  iterator pointing to the new logical end of the "kept" elements.
-    //
-    // The lambda [](Explosion& e) { return e.finished; } is the predicate.
-    // If it returns true, the element is considered removed.
-    // So: it marks explosions where e.finished == true.
-    //
-    // explosions.erase(...)
-    // This actually erases elements from the container, using the iterator returned by remove_if.
-    //
-    explosions.erase(
-        std::remove_if(explosions.begin(), explosions.end(),
-                       [](const Explosion &e) { return e.finished; }),
-        explosions.end()
-    );
-
-    for (auto &explosion : explosions) explosion.Draw(window, ecs);
+    for (auto &explosion : sim.explosions) explosion.Draw(window, ecs);
 
 
     ///////////////////////////////////////////////////////////////////////////////
@@ -602,9 +340,56 @@ if (!pellaDriveTexture.loadFromFile("../assets/textures/pella-drive.png")) {
     ///////////////////////////////////////////////////////////////////////////////
     sf::View hudView = window.getDefaultView();
     window.setView(hudView);
-    hud.DrawHUD(window, enemy1, enemy2, enemy3, zoomFactor);
+    hud.DrawHUD(window, sim.enemy1, sim.enemy2, sim.enemy3, zoomFactor);
     window.display();
   }
+
+  if (recordPath) {
+    if (replay.save(recordPath)) {
+      std::cout << "Recorded " << replay.ticks() << " steps to " << recordPath << "\n";
+    }
+    else {
+      std::cout << "Error saving the replay to " << recordPath << std::endl;
+    }
+  }
+}
+
+
+///////////////////////////////////////////////////////////////////////////////
+// The held keys and mouse buttons, and where the mouse is relative to the
+// player (drawn at the centre of the screen)
+///////////////////////////////////////////////////////////////////////////////
+PlayerInput sampleInput(const sf::RenderWindow &window, sf::Vector2f screenCentre) {
+  PlayerInput input;
+
+  const std::pair<sf::Keyboard::Key, PlayerInput::Button> keys[] = {
+      {sf::Keyboard::Key::H, PlayerInput::ROTATE_LEFT},   {sf::Keyboard::Key::L, PlayerInput::ROTATE_RIGHT},
+      {sf::Keyboard::Key::S, PlayerInput::FLIP_AND_STOP}, {sf::Keyboard::Key::E, PlayerInput::ATTACK_PDC},
+      {sf::Keyboard::Key::D, PlayerInput::DEFENCE_PDC},   {sf::Keyboard::Key::Space, PlayerInput::FIRE_TORPEDOES}};
+
+  for (auto [key, button] : keys) {
+    if (sf::Keyboard::isKeyPressed(key)) {
+      input.buttons |= button;
+    }
+  }
+
+  if (sf::Mouse::isButtonPressed(sf::Mouse::Button::Left)) {
+    input.buttons |= PlayerInput::BURN;
+  }
+  if (sf::Mouse::isButtonPressed(sf::Mouse::Button::Right)) {
+    input.buttons |= PlayerInput::STRAFE;
+  }
+
+  // the aim only counts while a mouse button is down, leaving it out the rest
+  // of the time keeps the replay log's runs long
+  if (!input.pressed(PlayerInput::BURN) && !input.pressed(PlayerInput::STRAFE)) {
+    return input;
+  }
+
+  sf::Vector2i mouse = sf::Mouse::getPosition(window);
+  input.aimX = static_cast<std::int16_t>(std::clamp(mouse.x - static_cast<int>(screenCentre.x), -32768, 32767));
+  input.aimY = static_cast<std::int16_t>(std::clamp(mouse.y - static_cast<int>(screenCentre.y), -32768, 32767));
+  return input;
 }
 
 
@@ -612,7 +397,7 @@ void DisplayWorldThreatRings(sf::RenderWindow& window, sf::Vector2f screenCentre
     // GUI outer radius is torpedo threat range
     // middle is pdc thread range
     // inner is best pdc range
-    std::array<int, 3> radius{8000, 16000, 45000};
+    std::array<float, 3> radius{BEST_PDC_RANGE, PDC_THREAT_RANGE, TORPEDO_THREAT_RANGE};
  
     // Circles
     for (auto r : radius) {
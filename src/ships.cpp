@@ -1,3 +1,4 @@
+#include "../include/assets.hpp"
 #include "../include/components.hpp"
 #include "../include/ecs.hpp"
 #include "../include/pdctarget.hpp"
@@ -8,7 +9,7 @@ void createBelterPdcs1(Coordinator &ecs, Entity e);
 
 class ShipFactory {
 public:
-  ShipFactory(Coordinator &ecs, sf::Texture &shipTexture, sf::Texture &driveTexture) :
+  ShipFactory(Coordinator &ecs, const TextureAsset &shipTexture, const TextureAsset &driveTexture) :
     ecs(ecs),
     shipTexture(shipTexture),
     driveTexture(driveTexture) {
@@ -19,14 +20,14 @@ public:
 
 protected:
   Coordinator &ecs;
-  sf::Texture &shipTexture;
-  sf::Texture &driveTexture;
+  const TextureAsset &shipTexture;
+  const TextureAsset &driveTexture;
 };
 
 // shold I make this a singleton?
 class PlayerShipFactory : public ShipFactory {
 public:
-  PlayerShipFactory(Coordinator &ecs, sf::Texture &shipTexture, sf::Texture &driveTexture) :
+  PlayerShipFactory(Coordinator &ecs, const TextureAsset &shipTexture, const TextureAsset &driveTexture) :
     ShipFactory(ecs, shipTexture, driveTexture) {}
  
   ~PlayerShipFactory() override = default;
@@ -36,20 +37,21 @@ public:
     ecs.addComponent(e, Position{{0,0}});
     ecs.addComponent(e, Velocity{{0.f, 0.f}});
     ecs.addComponent(e, Rotation{0.f});
+    ecs.addComponent(e, Orientation{0.f});
     ecs.addComponent(e, Health{health});
     ecs.addComponent(e, Acceleration{{0.f, 0.f}});
  
-    SpriteComponent sc{sf::Sprite(shipTexture)};
-    sf::Vector2f shipOrigin(shipTexture.getSize().x / 2.f,
-                            shipTexture.getSize().y / 2.f);
+    SpriteComponent sc{sf::Sprite(shipTexture.texture)};
+    sf::Vector2f shipOrigin(shipTexture.size.x / 2.f,
+                            shipTexture.size.y / 2.f);
     sc.sprite.setOrigin(shipOrigin);
     ecs.addComponent(e, sc);
 
     ecs.addComponent(e, Collision{e, ShapeType::AABB, 
                                   CollisionType::SHIP,
                                   100, // damage
-                                  static_cast<float>(shipTexture.getSize().x) / 2 - 45,
-                                  static_cast<float>(shipTexture.getSize().y) / 2 - 45, 0.f});
+                                  static_cast<float>(shipTexture.size.x) / 2 - 45,
+                                  static_cast<float>(shipTexture.size.y) / 2 - 45, 0.f});
 
     ecs.addComponent(e, TorpedoLauncher1{});
     ecs.addComponent(e, TorpedoLauncher2{});
@@ -68,9 +70,9 @@ private:
 
   // always has to be called after the player has been created
   void createPlayerDrivePlume(Entity player) {
-    SpriteComponent dc{sf::Sprite(driveTexture)};
-    sf::Vector2f driveOrigin(driveTexture.getSize().x - 40.f, // the is whitespace at the front of the png
-                             driveTexture.getSize().y / 2.f);
+    SpriteComponent dc{sf::Sprite(driveTexture.texture)};
+    sf::Vector2f driveOrigin(driveTexture.size.x - 40.f, // the is whitespace at the front of the png
+                             driveTexture.size.y / 2.f);
     dc.sprite.setOrigin(driveOrigin);
     dc.sprite.setScale(sf::Vector2f{0.f, 0.f});
 
@@ -82,7 +84,7 @@ private:
 class BelterFrigateShipFactory : public ShipFactory {
 
 public:
-  BelterFrigateShipFactory(Coordinator &ecs, sf::Texture &shipTexture, sf::Texture &driveTexture) : ShipFactory(ecs, shipTexture, driveTexture) {}
+  BelterFrigateShipFactory(Coordinator &ecs, const TextureAsset &shipTexture, const TextureAsset &driveTexture) : ShipFactory(ecs, shipTexture, driveTexture) {}
  
   ~BelterFrigateShipFactory() override = default;
 
@@ -93,20 +95,21 @@ public:
     ecs.addComponent(e, Position{position});
     ecs.addComponent(e, Velocity{velocity});
     ecs.addComponent(e, Rotation{rotation});
+    ecs.addComponent(e, Orientation{rotation});
     ecs.addComponent(e, Health{health});
     ecs.addComponent(e, Acceleration{{0.f, 0.f}});
  
-    SpriteComponent sc{sf::Sprite(shipTexture)};
-    sf::Vector2f shipOrigin(shipTexture.getSize().x / 2.f,
-                            shipTexture.getSize().y / 2.f);
+    SpriteComponent sc{sf::Sprite(shipTexture.texture)};
+    sf::Vector2f shipOrigin(shipTexture.size.x / 2.f,
+                            shipTexture.size.y / 2.f);
     sc.sprite.setOrigin(shipOrigin);
     ecs.addComponent(e, sc);
 
     ecs.addComponent(e, Collision{e, ShapeType::AABB, 
                                   CollisionType::SHIP,
                                   100, // damate
-                                  static_cast<float>(shipTexture.getSize().x) / 2 - 60,
-                                  static_cast<float>(shipTexture.getSize().y) / 2 - 60, 0.f});
+                                  static_cast<float>(shipTexture.size.x) / 2 - 60,
+                                  static_cast<float>(shipTexture.size.y) / 2 - 60, 0.f});
 
     ecs.addComponent(e, TorpedoLauncher1{.rounds = 10});
     ecs.addComponent(e, TorpedoLauncher2{.rounds = 10});
@@ -123,9 +126,9 @@ public:
 
 private:
   void createBelterDrivePlume(Entity belter) {
-    SpriteComponent dc{sf::Sprite(driveTexture)};
-    sf::Vector2f driveOrigin(driveTexture.getSize().x - 40.f, // the is whitespace at the front of the png
-                             driveTexture.getSize().y / 2.f);
+    SpriteComponent dc{sf::Sprite(driveTexture.texture)};
+    sf::Vector2f driveOrigin(driveTexture.size.x - 40.f, // the is whitespace at the front of the png
+                             driveTexture.size.y / 2.f);
     dc.sprite.setOrigin(driveOrigin);
     dc.sprite.setScale(sf::Vector2f{0.f, 0.f});
     ecs.addComponent(belter, DrivePlume{dc.sprite, sf::Vector2f{-800.f, 0.f}});
@@ -135,7 +138,7 @@ private:
 class BelterPellaShipFactory : public ShipFactory {
 
 public:
-  BelterPellaShipFactory(Coordinator &ecs, sf::Texture &shipTexture, sf::Texture &driveTexture) : ShipFactory(ecs, shipTexture, driveTexture) {}
+  BelterPellaShipFactory(Coordinator &ecs, const TextureAsset &shipTexture, const TextureAsset &driveTexture) : ShipFactory(ecs, shipTexture, driveTexture) {}
  
   ~BelterPellaShipFactory() override = default;
 
@@ -146,20 +149,21 @@ public:
     ecs.addComponent(e, Position{position});
     ecs.addComponent(e, Velocity{velocity});
     ecs.addComponent(e, Rotation{rotation});
+    ecs.addComponent(e, Orientation{rotation});
     ecs.addComponent(e, Health{health});
     ecs.addComponent(e, Acceleration{{0.f, 0.f}});
  
-    SpriteComponent sc{sf::Sprite(shipTexture)};
-    sf::Vector2f shipOrigin(shipTexture.getSize().x / 2.f,
-                            shipTexture.getSize().y / 2.f);
+    SpriteComponent sc{sf::Sprite(shipTexture.texture)};
+    sf::Vector2f shipOrigin(shipTexture.size.x / 2.f,
+                            shipTexture.size.y / 2.f);
     sc.sprite.setOrigin(shipOrigin);
     ecs.addComponent(e, sc);
 
     ecs.addComponent(e, Collision{e, ShapeType::AABB, 
                                   CollisionType::SHIP,
                                   100, // damate
-                                  static_cast<float>(shipTexture.getSize().x) / 2 - 60,
-                                  static_cast<float>(shipTexture.getSize().y) / 2 - 60, 0.f});
+                                  static_cast<float>(shipTexture.size.x) / 2 - 60,
+                                  static_cast<float>(shipTexture.size.y) / 2 - 60, 0.f});
 
     ecs.addComponent(e, TorpedoLauncher1{.rounds = 10});
     ecs.addComponent(e, TorpedoLauncher2{.rounds = 10});
@@ -179,9 +183,9 @@ public:
 
 private:
   void createPellaDrivePlume(Entity e) {
-    SpriteComponent dc{sf::Sprite(driveTexture)};
-    sf::Vector2f driveOrigin(driveTexture.getSize().x - 40.f, // the is whitespace at the front of the png
-                             driveTexture.getSize().y / 2.f);
+    SpriteComponent dc{sf::Sprite(driveTexture.texture)};
+    sf::Vector2f driveOrigin(driveTexture.size.x - 40.f, // the is whitespace at the front of the png
+                             driveTexture.size.y / 2.f);
     dc.sprite.setOrigin(driveOrigin);
     dc.sprite.setScale(sf::Vector2f{0.f, 0.f});
     ecs.addComponent(e, DrivePlume{dc.sprite, sf::Vector2f{-900.f, 0.f}});
@@ -0,0 +1,199 @@
+// roci-sim: the game's world with no window, textures or sound, stepped as
+// fast as it'll go. For profiling the systems and soak testing the sim
+// without a display.
+//
+//   roci-sim [--seconds <n>] [--tick-rate <hz>] [--seed <n>] [--scenario patrol|engagement]
+//            [--threads <n>] [--record <file>]
+//
+// runs n simulated seconds (default 60, rounded to whole steps) at the
+// game's fixed step (default 120 Hz), with the player flown by a simple
+// autopilot, then reports the ticks per second and how the fight went. The
+// engagement scenario starts the enemies in range (see Scenario). --threads
+// sizes the ECS thread pool (default one per core), it mustn't change the
+// game, so a replay can check a game recorded on another thread count.
+//
+//   roci-sim --replay <file>
+//
+// plays a game recorded with --record (here or in the game) again, step for
+// step, checks the world hash after every step and reports the slowest steps.
+#include "../include/assets.hpp"
+#include "../include/components.hpp"
+#include "../include/ecs.hpp"
+#include "../include/playerinput.hpp"
+#include "../include/replay.hpp"
+#include "../include/simulation.hpp"
+#include "../include/timestep.hpp"
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdlib>
+#include <cstring>
+#include <iomanip>
+#include <iostream>
+#include <thread>
+#include <utility>
+#include <vector>
+
+// the player's PDCs defend against torpedoes every step and both launchers
+// fire at the nearest enemy whenever they're ready
+PlayerInput autopilot() {
+  PlayerInput input;
+  input.buttons = PlayerInput::DEFENCE_PDC | PlayerInput::FIRE_TORPEDOES | PlayerInput::ASSIGN_LAUNCHER1 |
+                  PlayerInput::ASSIGN_LAUNCHER2;
+  return input;
+}
+
+int main(int argc, char *argv[]) {
+  float seconds = 60.f;
+  float tickRate = 120.f;
+  std::uint64_t seed = 1;
+  Scenario scenario = Scenario::PATROL;
+  unsigned threads = std::thread::hardware_concurrency();
+  const char *recordPath = nullptr;
+  const char *replayPath = nullptr;
+  for (int i = 1; i + 1 < argc; i += 2) {
+    if (std::strcmp(argv[i], "--seconds") == 0) {
+      seconds = std::strtof(argv[i + 1], nullptr);
+    }
+    else if (std::strcmp(argv[i], "--tick-rate") == 0) {
+      tickRate = std::strtof(argv[i + 1], nullptr);
+    }
+    else if (std::strcmp(argv[i], "--seed") == 0) {
+      seed = std::strtoull(argv[i + 1], nullptr, 10);
+    }
+    else if (std::strcmp(argv[i], "--scenario") == 0) {
+      if (std::strcmp(argv[i + 1], "engagement") == 0) {
+        scenario = Scenario::ENGAGEMENT;
+      }
+      else if (std::strcmp(argv[i + 1], "patrol") != 0) {
+        std::cout << "Unknown scenario " << argv[i + 1] << ", patrol or engagement" << std::endl;
+        return -1;
+      }
+    }
+    else if (std::strcmp(argv[i], "--threads") == 0) {
+      threads = static_cast<unsigned>(std::strtoul(argv[i + 1], nullptr, 10));
+    }
+    else if (std::strcmp(argv[i], "--record") == 0) {
+      recordPath = argv[i + 1];
+    }
+    else if (std::strcmp(argv[i], "--replay") == 0) {
+      replayPath = argv[i + 1];
+    }
+  }
+
+  // a replay brings its own seed, scenario, step and length
+  ReplayLog replay;
+  float dt = FixedTimestep(tickRate).step();
+  // rounded, not truncated: 20 s at 120 Hz is 2400 steps, even though
+  // 20 / (1 / 120.f) comes out a hair under 2400
+  unsigned long ticks = static_cast<unsigned long>(std::max(std::lround(seconds / dt), 0l));
+  if (replayPath) {
+    if (!replay.load(replayPath)) {
+      std::cout << "Error loading replay " << replayPath << std::endl;
+      return -1;
+    }
+    seed = replay.seed;
+    scenario = static_cast<Scenario>(replay.scenario);
+    dt = replay.dt;
+    ticks = replay.ticks();
+  }
+
+  // only the texture sizes, for the sprite origins and collision boxes
+  Assets assets;
+  if (!assets.load(true)) {
+    return -1;
+  }
+
+  Simulation sim(assets, dt, seed, scenario, threads);
+  ReplayLog recording(seed, dt, static_cast<std::uint8_t>(scenario));
+
+  std::cout << "roci-sim: " << ticks << " ticks of " << dt * 1000.f << " ms (" << ticks * dt
+            << " simulated seconds), seed " << seed
+            << (scenario == Scenario::ENGAGEMENT ? ", engagement" : "") << ", " << sim.ecs.threads().size()
+            << " threads" << (replayPath ? ", replaying " : "")
+            << (replayPath ? replayPath : "") << "\n";
+
+  // step times, only kept for a replay
+  std::vector<std::pair<double, unsigned long>> stepMs;
+  unsigned long firstMismatch = ticks;
+  std::size_t candidatePairs = 0; // the collision broadphase's, over all the steps
+
+  auto start = std::chrono::steady_clock::now();
+  for (unsigned long tick = 0; tick < ticks; ++tick) {
+    PlayerInput input = replayPath ? replay.input(tick) : autopilot();
+
+    if (replayPath) {
+      auto stepStart = std::chrono::steady_clock::now();
+      sim.step(input);
+      stepMs.push_back(
+          {std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - stepStart).count(), tick});
+
+      if (firstMismatch == ticks && hashWorld(sim.ecs, sim.tt) != replay.hash(tick)) {
+        firstMismatch = tick;
+      }
+    }
+    else {
+      sim.step(input);
+      if (recordPath) {
+        recording.record(input, hashWorld(sim.ecs, sim.tt));
+      }
+    }
+    candidatePairs += sim.collisionSystem.candidatePairs;
+  }
+  double wall = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+  ///////////////////////////////////////////////////////////////////////////////
+  // Report
+  ///////////////////////////////////////////////////////////////////////////////
+  std::cout << std::fixed << std::setprecision(3);
+  std::cout << "simulated " << ticks * dt << " s in " << ticks << " ticks\n";
+  std::cout << "wall time: " << wall << " s, " << std::setprecision(0) << ticks / wall << " ticks/s, "
+            << std::setprecision(1) << ticks * dt / wall << "x real time\n";
+
+  std::size_t entities = 0;
+  sim.ecs.each<Position>([&entities](Entity, Position &) { ++entities; });
+  std::cout << "entities: " << entities << ", explosions: " << sim.explosions.size() << "\n";
+  std::cout << "collision candidate pairs: " << std::setprecision(1)
+            << static_cast<double>(candidatePairs) / std::max(ticks, 1ul) << " per tick\n";
+
+  for (Entity ship : {sim.player, sim.enemy1, sim.enemy2, sim.enemy3}) {
+    if (sim.ecs.valid(ship)) {
+      std::cout << "  " << std::string(sim.ecs.getEntityName(ship)) << ": health "
+                << sim.ecs.getComponent<Health>(ship).value << "\n";
+    }
+    else {
+      std::cout << "  " << ship << ": destroyed\n";
+    }
+  }
+
+  std::cout << "systems:\n";
+  for (auto &timing : sim.scheduler.timings()) {
+    std::cout << "  " << timing.name << ": avg " << std::setprecision(3) << timing.averageMs << " ms\n";
+  }
+
+  if (recordPath) {
+    if (!recording.save(recordPath)) {
+      std::cout << "Error saving the replay to " << recordPath << std::endl;
+      return -1;
+    }
+    std::cout << "recorded " << recording.ticks() << " ticks (" << recording.inputRuns() << " input runs) to "
+              << recordPath << "\n";
+  }
+
+  if (replayPath) {
+    // the frames worth profiling
+    std::size_t slowest = std::min<std::size_t>(stepMs.size(), 5);
+    std::partial_sort(stepMs.begin(), stepMs.begin() + slowest, stepMs.end(),
+                      [](const auto &a, const auto &b) { return a.first > b.first; });
+    std::cout << "slowest ticks:\n";
+    for (std::size_t i = 0; i < slowest; ++i) {
+      std::cout << "  tick " << stepMs[i].second << ": " << stepMs[i].first << " ms\n";
+    }
+
+    if (firstMismatch != ticks) {
+      std::cout << "replay DIVERGED at tick " << firstMismatch << " (t = " << (firstMismatch + 1) * dt << " s)\n";
+      return 1;
+    }
+    std::cout << "replay matches, all " << ticks << " hashes\n";
+  }
+}
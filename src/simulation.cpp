@@ -0,0 +1,314 @@
+#include "../include/simulation.hpp"
+#include "../include/kinematics.hpp"
+#include "ships.cpp"
+#include <algorithm>
+
+// use this to control the pdc targeting
+enum class State {
+  IDLE,
+  ATTACK_PDC,
+  DEFENCE_PDC,
+};
+
+// an enemy's start for PATROL, moved in for ENGAGEMENT
+static sf::Vector2f enemyStart(Scenario scenario, sf::Vector2f position) {
+  return scenario == Scenario::ENGAGEMENT ? position / 10.f : position;
+}
+
+Simulation::Simulation(Assets &assets, float dt, std::uint64_t seed, Scenario scenario, unsigned threads) :
+    dt(dt),
+    seed(seed),
+    scenario(scenario),
+    ecs(threads),
+    ///////////////////////////////////////////////////////////////////////////////
+    // - Create Ship Entities -
+    ///////////////////////////////////////////////////////////////////////////////
+    player(PlayerShipFactory(ecs, assets.roci, assets.drive).createPlayerShip("Rocinante", 1300)),
+    enemy1(BelterFrigateShipFactory(ecs, assets.belterFrigate, assets.drive)
+               .createBelterFrigateShip("Bashi Bazouk", enemyStart(scenario, {14000.f, -280000.f}), {0.f, 0.f}, 90.f,
+                                        200)),
+    enemy2(BelterFrigateShipFactory(ecs, assets.belterFrigate, assets.drive)
+               .createBelterFrigateShip("Behemoth", enemyStart(scenario, {-50000.f, -280000.f}), {0.f, 0.f}, 90.f,
+                                        200)),
+    enemy3(BelterPellaShipFactory(ecs, assets.pella, assets.pellaDrive)
+               .createBelterPellaShip("Pella", enemyStart(scenario, {-30000.f, -300000.f}), {0.f, 0.f}, 90.f,
+                                      500)),
+
+    bulletFactory(ecs, assets.bullet),
+    torpedoFactory(ecs, assets.torpedo),
+    incomingTorpedoes(ecs),
+
+    ///////////////////////////////////////////////////////////////////////////////
+    // Create Enemy and Torpedo AIs
+    ///////////////////////////////////////////////////////////////////////////////
+    enemy1AI(ecs, enemy1, bulletFactory, torpedoFactory, assets.pdcFire, incomingTorpedoes),
+    enemy2AI(ecs, enemy2, bulletFactory, torpedoFactory, assets.pdcFire, incomingTorpedoes),
+    enemy3AI(ecs, enemy3, bulletFactory, torpedoFactory, assets.pdcFire, incomingTorpedoes),
+    torpedoAI(ecs),
+
+    pdcTargeting(ecs, player, bulletFactory, assets.pdcFire, incomingTorpedoes),
+    torpedoTargeting(ecs, player, torpedoFactory),
+
+    asteroidFactory(ecs, assets.asteroid, seed),
+    collisionSystem(ecs, assets.pdcHit, assets.explosionSound, explosions, assets.explosion.texture, asteroidFactory),
+    damageSystem(ecs, assets.explosionSound, explosions, assets.explosion.texture),
+    scheduler(ecs) {
+
+  asteroidFactory.createInitialAsteroids();
+  addSystems();
+}
+
+void Simulation::step(const PlayerInput &stepInput) {
+  input = stepInput;
+  tt += dt;
+  scheduler.run();
+}
+
+///////////////////////////////////////////////////////////////////////////////
+// - Systems -
+// Each system says which components it reads and writes, anything that
+// creates/destroys entities or reads the input is exclusive. Conflicting
+// systems run in the order they're added here, the rest run in parallel.
+///////////////////////////////////////////////////////////////////////////////
+void Simulation::addSystems() {
+  using Access = Scheduler<Coordinator>::Access;
+  enum Resource : unsigned { EXPLOSIONS };
+
+  scheduler.add("physics", Access().reads<Acceleration>().writes<Velocity, Position, Rotation, Orientation>(), [this] {
+    ///////////////////////////////////////////////////////////////////////////////
+    // - Physics: A->V->P -
+    ///////////////////////////////////////////////////////////////////////////////
+    // everything that moves, spread over the ECS thread pool. One fused SIMD
+    // pass with the archetype storage, a loop per component with sparse sets
+    updateKinematics(ecs, dt);
+  });
+
+  // Collision System - check for collisions
+  // destroyed entities and debris are applied at the flush
+  scheduler.add("collision", Access().exclusive(), [this] {
+    collisionSystem.Update();
+    ecs.flush();
+  });
+
+  scheduler.add("player controls", Access().exclusive(), [this] { controlPlayer(input); });
+
+  ///////////////////////////////////////////////////////////////////////////////
+  // - Update everying else -
+  ///////////////////////////////////////////////////////////////////////////////
+  // Enemy & Torpedo AIs
+  scheduler.add("torpedo targeting", Access().exclusive(), [this] {
+    torpedoTargeting.Update<EnemyShipTarget>(); // re-aquire targets for the torpedos
+  });
+
+  scheduler.add("enemy ai", Access().exclusive(), [this] {
+    if (ecs.valid(enemy1))
+      enemy1AI.Update(tt, dt);
+
+    if (ecs.valid(enemy2))
+      enemy2AI.Update(tt, dt);
+
+    if (ecs.valid(enemy3))
+      enemy3AI.Update(tt, dt);
+  });
+
+  // only steers torpedoes towards their targets, so it runs next to the
+  // explosion animation
+  scheduler.add("torpedo ai",
+                Access()
+                    .reads<Position, Velocity, TorpedoTarget>()
+                    .writes<Acceleration, Rotation, TorpedoControl>(),
+                [this] { torpedoAI.Update(tt, dt); });
+
+  scheduler.add("explosions", Access().uses(EXPLOSIONS), [this] {
+    // Animate the explosions
+    for (auto &explosion : explosions) explosion.Update(dt);
+
+    // Remove all finished explosions
+    //
+    // std::remove_if : This rearranges the vector so that all unwanted elements
+    //                  (e.finished == true) are moved to the end. It returns an
+    //                  iterator pointing to the new logical end of the "kept" elements.
+    //
+    // The lambda [](Explosion& e) { return e.finished; } is the predicate.
+    // If it returns true, the element is considered removed.
+    // So: it marks explosions where e.finished == true.
+    //
+    // explosions.erase(...)
+    // This actually erases elements from the container, using the iterator returned by remove_if.
+    //
+    explosions.erase(
+        std::remove_if(explosions.begin(), explosions.end(),
+                       [](const Explosion &e) { return e.finished; }),
+        explosions.end()
+    );
+  });
+
+  scheduler.add("bullets", Access().exclusive(), [this] {
+    bulletFactory.Update(tt); // remove bullets that have been fired for too long
+  });
+
+  // DamageSystem
+  scheduler.add("damage", Access().exclusive().uses(EXPLOSIONS), [this] {
+    damageSystem.Update();
+    ecs.flush();
+  });
+}
+
+///////////////////////////////////////////////////////////////////////////////
+// - Player controls -
+///////////////////////////////////////////////////////////////////////////////
+void Simulation::controlPlayer(const PlayerInput &input) {
+  if (!ecs.valid(player))
+    return;
+
+  const sf::Vector2f aim(static_cast<float>(input.aimX), static_cast<float>(input.aimY));
+  State state = State::IDLE;
+
+  // main ship control structure
+  auto &shipControl = ecs.getComponent<ShipControl>(player);
+
+  ///////////////////////////////////////////////////////////////////////////////
+  // Torpedo targets and constant acceleration, one step per key release
+  ///////////////////////////////////////////////////////////////////////////////
+  if (input.pressed(PlayerInput::NEXT_TARGET)) {
+    torpedoTargeting.selectNextTarget();
+  }
+  if (input.pressed(PlayerInput::ASSIGN_LAUNCHER1)) {
+    torpedoTargeting.setLauncher1Target(torpedoTargeting.getTargetEntity());
+  }
+  if (input.pressed(PlayerInput::ASSIGN_LAUNCHER2)) {
+    torpedoTargeting.setLauncher2Target(torpedoTargeting.getTargetEntity());
+  }
+  if (input.pressed(PlayerInput::MORE_ACCEL)) {
+    constAccelGs = std::clamp(constAccelGs + 1.f, 0.f, 10.f);
+  }
+  if (input.pressed(PlayerInput::LESS_ACCEL)) {
+    constAccelGs = std::clamp(constAccelGs - 1.f, 0.f, 10.f);
+  }
+
+  ///////////////////////////////////////////////////////////////////////////////
+  // Flying the ship
+  ///////////////////////////////////////////////////////////////////////////////
+
+  if (shipControl.state != ControlState::IDLE) {
+    ///////////////////////////////////////////////////////////////////////////////
+    // Control the flip or turns(if needed)
+    ///////////////////////////////////////////////////////////////////////////////
+    updateControlState(ecs, shipControl, player, tt, dt);
+  }
+  else if (shipControl.state == ControlState::IDLE) {
+
+    if (input.pressed(PlayerInput::ROTATE_LEFT)) {
+      // rotate left
+      auto &rot = ecs.getComponent<Rotation>(player);
+      //rot.angle -= (window.getSize().x / 500.f);
+      rot.angle -= 90.f * dt;
+      rot.angle = normalizeAngle(rot.angle);
+    }
+    else if (input.pressed(PlayerInput::ROTATE_RIGHT)) {
+      // rotate right
+      auto &rot = ecs.getComponent<Rotation>(player);
+      // rot.angle += (window.getSize().x / 500.f);
+      rot.angle += 90.f * dt;
+      rot.angle = normalizeAngle(rot.angle);
+    }
+
+    if (input.pressed(PlayerInput::BURN)) {
+      ///////////////////////////////////////////////////////////////////////////////
+      // Use the left mouse key to set rotation and acceleration
+      ///////////////////////////////////////////////////////////////////////////////
+
+      // turn off constant acceleration
+      constAccelGs = 0.f;
+
+      // the player is drawn at the centre of the screen, so the aim is the
+      // vector from the player to the mouse
+      sf::Vector2f newVector = aim;
+
+      // std::cout << "new vector length " << newVector.length()
+      //           << " angle: " << newVector.angle().asDegrees() << "\n";
+
+      // turn towards the vector
+      if (newVector.length() > 0.f) {
+        // std::cout << "Turning towards vector: " << newVector.angle().asDegrees() << "\n";
+        startTurn(ecs, shipControl, player, newVector.angle().asDegrees()); 
+
+        float maxAccel = newVector.length() / 30.f; 
+        maxAccel = std::clamp(maxAccel, 0.f, 10.f); // limit to 10 Gs
+ 
+        // use the distance from the mouse click to set acceleration, max 10 Gs
+        accelerateToMax(ecs, shipControl, player, maxAccel, dt);
+      }
+    }
+    else if (input.pressed(PlayerInput::STRAFE)) {
+
+      // turn off constant acceleration
+      constAccelGs = 0.f;
+
+      ///////////////////////////////////////////////////////////////////////////////
+      // Use the right mouse key to strafe
+
+      ///////////////////////////////////////////////////////////////////////////////
+      auto &vel = ecs.getComponent<Velocity>(player);
+
+      sf::Vector2f newVector = aim;
+
+      // std::cout << "new vector length " << newVector.length()
+      //           << " angle: " << newVector.angle().asDegrees() << "\n";
+
+      // strafe towards the vector
+      if (newVector.length() > 0.f) {
+        // take this vector and strafe towards it
+
+        // vel.value.x += std::cos((newVector.angle().asRadians())) * 1000.f * dt;
+        // vel.value.y += std::sin((newVector.angle().asRadians())) * 1000.f * dt;
+        vel.value += newVector.normalized() * 500.f * dt;
+      }
+    }
+    else if (input.pressed(PlayerInput::FLIP_AND_STOP)) {
+      // flip and decelerate
+      // debounce the flip
+      // rotate to burn and reduce velocity, may not be 180 if there is 
+      // some lateral movement
+      startFlipAndStop(ecs, shipControl, player, 8.0f, tt);
+    }
+    else {
+      accelerateToMax(ecs, shipControl, player, constAccelGs, dt);
+    }
+  }
+ 
+
+  ///////////////////////////////////////////////////////////////////////////////
+  // Fire! Attacking PDCs
+  ///////////////////////////////////////////////////////////////////////////////
+  if (input.pressed(PlayerInput::ATTACK_PDC)) {
+    state = State::ATTACK_PDC;
+  }
+
+  ///////////////////////////////////////////////////////////////////////////////
+  // Fire! Defensive PDCs Change to defence state
+  ///////////////////////////////////////////////////////////////////////////////
+  if (input.pressed(PlayerInput::DEFENCE_PDC)) {
+    state = State::DEFENCE_PDC;
+  }
+
+  ///////////////////////////////////////////////////////////////////////////////
+  // simple state machine 
+  // target all pdcs if attacking enemy, this updates the display of pdc target heading
+  ///////////////////////////////////////////////////////////////////////////////
+  if (state == State::ATTACK_PDC) {
+    // target the enemy
+    pdcTargeting.pdcAttack<EnemyShipTarget>(tt);
+  }
+  else if (state == State::DEFENCE_PDC) {
+    // target the nearest torpedo
+    pdcTargeting.pdcDefendTorpedo(tt, dt);
+  }
+
+  ///////////////////////////////////////////////////////////////////////////////
+  // Fire! Torpedo 1 & 2
+  ///////////////////////////////////////////////////////////////////////////////
+  if (input.pressed(PlayerInput::FIRE_TORPEDOES)) {
+    torpedoTargeting.fireBoth(tt);
+  }
+}